@@ -0,0 +1,40 @@
+#pragma once
+/*
+ * Small helpers shared by the benchmarks: the competition inputs and a best-of-n timer, with an optional untimed reset
+ */
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <limits>
+
+inline const std::array<std::string, 4> INPUT_FILES = { "charleston_road.in", "lets_go_higher.in", "opera.in", "rue_de_londres.in" };
+
+// The benchmarks are run from a build directory inside bench/, like the solvers
+inline std::string input_prefix(int argc, char** argv)
+{
+    return argc > 1 ? std::string(argv[1]) : std::string("../../input_files/");
+}
+
+// Runs 'kernel' 'repetitions' times, each time after reset() (untimed), and returns the fastest run, in milliseconds
+template <typename Kernel, typename Reset>
+double best_time_ms(Kernel&& kernel, int repetitions, Reset&& reset)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int run = 0; run < repetitions; ++run)
+    {
+        reset();
+        const auto start = std::chrono::steady_clock::now();
+        kernel();
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+template <typename Kernel>
+double best_time_ms(Kernel&& kernel, int repetitions = 3)
+{
+    return best_time_ms(kernel, repetitions, [] {});
+}
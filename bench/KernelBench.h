@@ -0,0 +1,124 @@
+#pragma once
+/*
+ * Harness of the kernel benchmarks: every kernel is timed in isolation on a fixture (one per input file), as the
+ * best of a few runs with its state reset before each one, and reported in ns/op and throughput; the parallel ones
+ * are also run on pools of 1, 2, 4, ... threads, up to the hardware threads, to show how they scale.
+ *
+ * Usage: <bench> [input prefix] [kernel name filter]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "../common/ThreadPool.h"
+
+class KernelBench
+{
+private:
+    std::string filter;
+    int repetitions;
+
+public:
+
+    // Only the kernels whose name contains 'filter' are run
+    explicit KernelBench(int argc, char** argv, int repetitions = 5)
+    : filter(argc > 2 ? argv[2] : "")
+    , repetitions(repetitions)
+    {
+    }
+
+    // 1, 2, 4, ... threads, and the hardware threads
+    static std::vector<size_t> thread_counts()
+    {
+        std::vector<size_t> counts;
+        const size_t hardware_threads = ThreadPool::default_nr_threads();
+        for (size_t nr_threads = 1; nr_threads < hardware_threads; nr_threads *= 2)
+            counts.push_back(nr_threads);
+        counts.push_back(hardware_threads);
+        return counts;
+    }
+
+    // Title of a fixture, followed by the column headers
+    static void print_fixture(const std::string& input_file, int nr_rows, int nr_columns, int router_radius)
+    {
+        std::printf("\n%s (%d x %d, R = %d)\n", input_file.c_str(), nr_rows, nr_columns, router_radius);
+        std::printf("%-46s %7s %10s %14s %14s %22s %8s\n", "kernel", "threads", "ms", "ns/op", "ops/s", "throughput", "speedup");
+    }
+
+    [[nodiscard]] bool selected(const std::string& kernel) const
+    {
+        return kernel.find(filter) != std::string::npos;
+    }
+
+    // One line of the report: the run did 'nr_ops' operations over 'nr_items' items (cells, queries...)
+    static void print_line(const std::string& kernel, size_t nr_threads, double ms, size_t nr_ops, size_t nr_items,
+                           const char* item_unit, double single_thread_ms = 0)
+    {
+        const double seconds = std::max(ms, 1e-6) / 1000;
+        // Scaled to the largest prefix that keeps a digit before the point
+        double rate = nr_items / seconds;
+        const char* prefix = "";
+        for (const char* larger : { "k", "M", "G" })
+            if (rate >= 1000)
+            {
+                rate /= 1000;
+                prefix = larger;
+            }
+        char throughput[32];
+        std::snprintf(throughput, sizeof(throughput), "%.1f %s%s/s", rate, prefix, item_unit);
+        std::printf("%-46s %7zu %10.3f %14.1f %14.0f %22s", kernel.c_str(), nr_threads, ms, ms * 1e6 / std::max<size_t>(nr_ops, 1),
+                    nr_ops / seconds, throughput);
+        if (single_thread_ms > 0)
+            std::printf(" %7.2fx", single_thread_ms / ms);
+        std::printf("\n");
+    }
+
+    // A kernel run on the calling thread: body() does 'nr_ops' operations over 'nr_items' items
+    template <typename Reset, typename Body>
+    void run(const std::string& kernel, size_t nr_ops, size_t nr_items, const char* item_unit, Reset&& reset, Body&& body) const
+    {
+        if (!selected(kernel))
+            return;
+        print_line(kernel, 1, best_time_ms(body, repetitions, reset), nr_ops, nr_items, item_unit);
+    }
+
+    template <typename Body>
+    void run(const std::string& kernel, size_t nr_ops, size_t nr_items, const char* item_unit, Body&& body) const
+    {
+        run(kernel, nr_ops, nr_items, item_unit, [] {}, body);
+    }
+
+    // A parallel kernel, run once per thread count: body(pool) runs it on 'pool'
+    template <typename Reset, typename Body>
+    void run_scaling(const std::string& kernel, size_t nr_ops, size_t nr_items, const char* item_unit, Reset&& reset, Body&& body) const
+    {
+        if (!selected(kernel))
+            return;
+
+        double single_thread_ms = 0;
+        for (const size_t nr_threads : thread_counts())
+        {
+            ThreadPool pool(nr_threads);
+            const double ms = best_time_ms([&] { body(pool); }, repetitions, reset);
+            if (nr_threads == 1)
+                single_thread_ms = ms;
+            print_line(kernel, nr_threads, ms, nr_ops, nr_items, item_unit, single_thread_ms);
+        }
+    }
+
+    template <typename Body>
+    void run_scaling(const std::string& kernel, size_t nr_ops, size_t nr_items, const char* item_unit, Body&& body) const
+    {
+        run_scaling(kernel, nr_ops, nr_items, item_unit, [] {}, body);
+    }
+};
+
+// Keeps the compiler from optimizing away a result that is not used otherwise
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
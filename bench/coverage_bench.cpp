@@ -0,0 +1,183 @@
+#include <iostream>
+#include <iomanip>
+
+#include "BenchUtils.h"
+#include "../common/BuildingPlan.h"
+#include "../common/BitGrid.h"
+#include "../common/Grid.h"
+#include "../common/CoverageCounter.h"
+
+using namespace std;
+
+/*
+ * Whole-map coverage counts (sol3's initialize_coverable_cells, single threaded), computed by the byte-per-cell
+ * column sweep, then by CoverageCounter's bitplane sweep with its scalar path and its AVX2 + POPCNT path (256-bit
+ * row folding, hardware popcount of the target bitplane).
+ */
+
+namespace byte_sweep
+{
+    class ByteSweepCounter
+    {
+    private:
+        int radius;
+
+        // One byte per cell, so that folding a row into the column state is a plain vectorizable OR
+        Grid<char> wall_cells;
+
+        // countable_prefix[x][y] is the number of countable targets in row x, columns [0, y)
+        Grid<unsigned int> countable_prefix;
+
+    public:
+
+        // The cells counted are the ones set in 'targets' and not set in 'excluded' (e.g. already covered ones)
+        ByteSweepCounter(const BitGrid& walls, const BitGrid& targets, int router_radius, const BitGrid* excluded = nullptr)
+        : radius(router_radius)
+        , wall_cells(walls.rows(), walls.columns(), 0)
+        , countable_prefix(targets.rows(), targets.columns() + 1, 0)
+        {
+            for (size_t x = 0; x < walls.rows(); ++x)
+                for (size_t y = 0; y < walls.columns(); ++y)
+                    wall_cells[x][y] = walls.test(x, y);
+
+            for (size_t x = 0; x < targets.rows(); ++x)
+            {
+                unsigned int* prefix = countable_prefix[x];
+                for (size_t y = 0; y < targets.columns(); ++y)
+                    prefix[y + 1] = prefix[y] + (targets.test(x, y) && !(excluded && excluded->test(x, y)));
+            }
+        }
+
+        // Writes, for every (i, j) of the window [(i1, j1), (i2, j2)], the number of countable targets a router
+        // placed there covers, or 0 where is_candidate(i, j) does not hold. Windows can be processed concurrently.
+        template <typename IsCandidate>
+        void count_window(Grid<unsigned int>& coverage, int i1, int j1, int i2, int j2, IsCandidate&& is_candidate) const
+        {
+            const int nr_rows = wall_cells.rows(), nr_columns = wall_cells.columns();
+
+            // Only the columns within R of the window can block or be covered
+            const int first_column = std::max(0, j1 - radius);
+            const int last_column = std::min(nr_columns - 1, j2 + radius);
+            const int width = last_column - first_column + 1;
+
+            std::vector<char> column_blocked(width), candidate(j2 - j1 + 1);
+            std::vector<int> next_block(width + 1);
+            std::vector<unsigned int> totals(j2 - j1 + 1);
+
+            for (int i = i1; i <= i2; ++i)
+            {
+                bool any_candidate = false;
+                for (int j = j1; j <= j2; ++j)
+                    any_candidate |= (candidate[j - j1] = is_candidate(i, j));
+                std::fill(totals.begin(), totals.end(), 0);
+
+                if (!any_candidate)
+                {
+                    std::fill(coverage[i] + j1, coverage[i] + j2 + 1, 0);
+                    continue;
+                }
+
+                // The lower half (router row included), then the upper half
+                for (const int direction : { 1, -1 })
+                {
+                    std::fill(column_blocked.begin(), column_blocked.end(), 0);
+                    if (direction == -1)
+                        std::copy(wall_cells[i] + first_column, wall_cells[i] + first_column + width, column_blocked.begin());
+
+                    for (int step = (direction == 1) ? 0 : 1; step <= radius; ++step)
+                    {
+                        const int x = i + direction * step;
+                        if (x < 0 || x >= nr_rows)
+                            break;
+
+                        // column_blocked[c]: is there a wall in column c between rows i and x
+                        const char* wall_row = wall_cells[x] + first_column;
+                        for (int c = 0; c < width; ++c)
+                            column_blocked[c] |= wall_row[c];
+
+                        next_block[width] = width;
+                        for (int c = width - 1; c >= 0; --c)
+                            next_block[c] = column_blocked[c] ? c : next_block[c + 1];
+
+                        const unsigned int* prefix = countable_prefix[x] + first_column;
+                        bool any_open = false;
+                        int previous_block = -1;
+                        for (int c = 0; c < width; ++c)
+                        {
+                            if (column_blocked[c])
+                            {
+                                previous_block = c;
+                                continue;
+                            }
+
+                            const int j = first_column + c;
+                            if (j < j1 || j > j2 || !candidate[j - j1])
+                                continue;
+
+                            const int right_end = std::min(next_block[c] - 1, c + radius);
+                            const int left_start = std::max(previous_block + 1, c - radius);
+                            totals[j - j1] += prefix[right_end + 1] - prefix[left_start];
+                            any_open = true;
+                        }
+
+                        // Blocked columns stay blocked further out, so this half is done for every router of row i
+                        if (!any_open)
+                            break;
+                    }
+                }
+
+                unsigned int* coverage_row = coverage[i];
+                for (int j = j1; j <= j2; ++j)
+                    coverage_row[j] = candidate[j - j1] ? totals[j - j1] : 0;
+            }
+        }
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const string in_prefix = input_prefix(argc, argv);
+    const bool has_avx2 = coverage_simd::best_isa() == CoverageIsa::Avx2;
+
+    cout << left << setw(22) << "input" << right << setw(14) << "bytes (ms)" << setw(14) << "scalar (ms)"
+         << setw(14) << "AVX2 (ms)" << setw(10) << "speedup" << '\n';
+    for (const string& input_file : INPUT_FILES)
+    {
+        const BuildingPlan plan(in_prefix + input_file);
+        const int nr_rows = plan.rows(), nr_columns = plan.columns(), radius = plan.header().router_radius;
+        const BitGrid walls(nr_rows, nr_columns, [&](int i, int j) { return plan[i][j] == '#'; });
+        const BitGrid targets(nr_rows, nr_columns, [&](int i, int j) { return plan[i][j] == '.'; });
+        const auto can_place_router = [&](int i, int j) { return plan[i][j] == '.'; };
+
+        const byte_sweep::ByteSweepCounter byte_counter(walls, targets, radius);
+        CoverageCounter scalar_counter(walls, targets, radius), avx2_counter(walls, targets, radius);
+        scalar_counter.force_isa(CoverageIsa::Scalar);
+        avx2_counter.force_isa(CoverageIsa::Avx2);
+
+        Grid<unsigned int> expected(nr_rows, nr_columns), coverage(nr_rows, nr_columns);
+        const auto run = [&](const auto& counter, Grid<unsigned int>& result)
+        {
+            return best_time_ms([&] { counter.count_window(result, 0, 0, nr_rows - 1, nr_columns - 1, can_place_router); });
+        };
+        const auto matches = [&]
+        {
+            for (int i = 0; i < nr_rows; ++i)
+                if (!equal(expected[i], expected[i] + nr_columns, coverage[i]))
+                    return false;
+            return true;
+        };
+
+        const double bytes_ms = run(byte_counter, expected);
+        const double scalar_ms = run(scalar_counter, coverage);
+        bool correct = matches();
+        // Without AVX2 the forced path falls back to the scalar one
+        const double avx2_ms = run(avx2_counter, coverage);
+        correct &= matches();
+
+        cout << left << setw(22) << input_file << right << fixed << setprecision(1) << setw(14) << bytes_ms
+             << setw(14) << scalar_ms << setw(14) << avx2_ms << setw(9) << setprecision(2)
+             << bytes_ms / min(scalar_ms, avx2_ms) << 'x' << (has_avx2 ? "" : " (no AVX2)")
+             << (correct ? "" : " MISMATCH") << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <iostream>
+#include <iomanip>
+#include <memory>
+
+#include "BenchUtils.h"
+#include "../common/BuildingPlan.h"
+#include "../common/Grid.h"
+#include "../common/SummedAreaTable.h"
+#include "../common/ThreadPool.h"
+
+using namespace std;
+
+/*
+ * sol3's initialize_coverable_cells, run once over the old layout (one heap allocation per row,
+ * summed-area table clamped at the border) and once over Grid / SummedAreaTable, both with the rows spread over the
+ * shared thread pool.
+ */
+
+namespace legacy
+{
+    using Rows = unique_ptr<unique_ptr<unsigned int[]>[]>;
+
+    Rows allocate(int nr_rows, int nr_columns)
+    {
+        auto rows = make_unique<unique_ptr<unsigned int[]>[]>(nr_rows);
+        for (int index = 0; index < nr_rows; ++index)
+            rows[index] = make_unique<unsigned int[]>(nr_columns);
+        return rows;
+    }
+
+    unsigned int compute_rect_sum(int i1, int j1, int i2, int j2, const Rows& int_map)
+    {
+        unsigned int result = int_map[i2][j2];
+        const int above = max(i1 - 1, 0);
+        const int left = max(j1 - 1, 0);
+        return result - int_map[above][j2] - int_map[i2][left] + int_map[above][left];
+    }
+
+    void initialize_coverable_cells(const BuildingPlan& plan, const Rows& wall_map,
+                                    const unique_ptr<unique_ptr<bool[]>[]>& visited, Rows& nr_coverable_cells)
+    {
+        const int nr_rows = plan.rows(), nr_columns = plan.columns(), radius = plan.header().router_radius;
+
+        ThreadPool::global().parallel_for(0, nr_rows, 1, [&](size_t row)
+        {
+            const int i = (int)row;
+            for (int j = 0; j < nr_columns; ++j)
+            {
+                int sum = 0;
+                if (plan[i][j] == '.')
+                    for (int x = max(0, i - radius); x <= min(nr_rows - 1, i + radius); ++x)
+                        for (int y = max(0, j - radius); y <= min(nr_columns - 1, j + radius); ++y)
+                            if (plan[x][y] == '.' && !visited[x][y] &&
+                                !compute_rect_sum(min(i, x), min(j, y), max(i, x), max(j, y), wall_map))
+                                sum++;
+                nr_coverable_cells[i][j] = sum;
+            }
+        });
+    }
+}
+
+namespace contiguous
+{
+    void initialize_coverable_cells(const BuildingPlan& plan, const SummedAreaTable& wall_map,
+                                    const Grid<bool>& visited, Grid<unsigned int>& nr_coverable_cells)
+    {
+        const int nr_rows = plan.rows(), nr_columns = plan.columns(), radius = plan.header().router_radius;
+
+        ThreadPool::global().parallel_for(0, nr_rows, 1, [&](size_t row)
+        {
+            const int i = (int)row;
+            for (int j = 0; j < nr_columns; ++j)
+            {
+                int sum = 0;
+                if (plan[i][j] == '.')
+                    for (int x = max(0, i - radius); x <= min(nr_rows - 1, i + radius); ++x)
+                    {
+                        const char* plan_row = plan[x];
+                        const bool* visited_row = visited[x];
+                        const unsigned int* top = wall_map.prefix_row(min(i, x));
+                        const unsigned int* bottom = wall_map.prefix_row(max(i, x) + 1);
+
+                        for (int y = max(0, j - radius); y <= min(nr_columns - 1, j + radius); ++y)
+                        {
+                            const int left = min(j, y), right = max(j, y) + 1;
+                            if (plan_row[y] == '.' && !visited_row[y] && bottom[right] - top[right] - bottom[left] + top[left] == 0)
+                                sum++;
+                        }
+                    }
+                nr_coverable_cells[i][j] = sum;
+            }
+        });
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const string in_prefix = input_prefix(argc, argv);
+
+    cout << left << setw(22) << "input" << right << setw(14) << "legacy (ms)" << setw(14) << "Grid (ms)" << setw(10) << "speedup" << '\n';
+    for (const string& input_file : INPUT_FILES)
+    {
+        const BuildingPlan plan(in_prefix + input_file);
+        const int nr_rows = plan.rows(), nr_columns = plan.columns();
+        const auto is_wall = [&](int i, int j) { return plan[i][j] == '#'; };
+
+        // Old layout
+        auto legacy_walls = legacy::allocate(nr_rows, nr_columns);
+        for (int i = 0; i < nr_rows; ++i)
+            for (int j = 0; j < nr_columns; ++j)
+                legacy_walls[i][j] = is_wall(i, j) + (j ? legacy_walls[i][j - 1] : 0) + (i ? legacy_walls[i - 1][j] : 0)
+                                     - (i && j ? legacy_walls[i - 1][j - 1] : 0);
+        auto legacy_visited = make_unique<unique_ptr<bool[]>[]>(nr_rows);
+        for (int index = 0; index < nr_rows; ++index)
+            legacy_visited[index] = make_unique<bool[]>(nr_columns);
+        auto legacy_coverage = legacy::allocate(nr_rows, nr_columns);
+
+        // New layout
+        const SummedAreaTable walls(nr_rows, nr_columns, is_wall);
+        const Grid<bool> visited(nr_rows, nr_columns, false);
+        Grid<unsigned int> coverage(nr_rows, nr_columns);
+
+        const double legacy_ms = best_time_ms([&] { legacy::initialize_coverable_cells(plan, legacy_walls, legacy_visited, legacy_coverage); });
+        const double grid_ms = best_time_ms([&] { contiguous::initialize_coverable_cells(plan, walls, visited, coverage); });
+
+        cout << left << setw(22) << input_file << right << fixed << setprecision(1)
+             << setw(14) << legacy_ms << setw(14) << grid_ms << setw(9) << setprecision(2) << legacy_ms / grid_ms << "x\n";
+    }
+    return 0;
+}
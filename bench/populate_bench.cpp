@@ -0,0 +1,131 @@
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <queue>
+#include <set>
+
+#include "BenchUtils.h"
+#include "../common/BuildingPlan.h"
+#include "../common/BitGrid.h"
+#include "../common/Grid.h"
+#include "../common/CoverageCounter.h"
+#include "../sol3/CandidateQueue.h"
+#include "../common/ThreadPool.h"
+
+using namespace std;
+
+/*
+ * sol3's populate_pqueue_parallel on thread pools of 1 to 32 threads, pushing into the old mutex + std::set queue and
+ * into CandidateQueue's per-band buffers (then its bucket queue). The bands of rows are handed out as in the solver.
+ * The backbone distance lookup is replaced by the distance to the backbone start, so that only the collection of the
+ * candidates is measured. Counts above the hardware threads are oversubscribed, which still exposes lock contention.
+ */
+
+namespace legacy
+{
+    class ThreadSafePriorityQueue{
+    public:
+        using triple = std::pair<int, Point>;
+
+        struct cmp{
+            bool operator()(const triple& a, const triple& b) const
+            {
+                return a.first < b.first; // max-heap
+            }
+        };
+
+        void push(const triple& t)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (seen.insert(t).second)
+                pq.push(t);
+        }
+
+        size_t size()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            return pq.size();
+        }
+
+    private:
+        std::priority_queue<triple, std::vector<triple>, cmp> pq;
+        std::set<triple> seen;
+        std::mutex mtx;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const string in_prefix = input_prefix(argc, argv);
+    const array<int, 6> thread_counts = { 1, 2, 4, 8, 16, 32 };
+
+    cout << "hardware threads: " << ThreadPool::default_nr_threads() << '\n';
+    for (const string& input_file : INPUT_FILES)
+    {
+        const BuildingPlan plan(in_prefix + input_file);
+        const PlanHeader& header = plan.header();
+        const int nr_rows = plan.rows(), nr_columns = plan.columns();
+        const BitGrid walls(nr_rows, nr_columns, [&](int i, int j) { return plan[i][j] == '#'; });
+        const BitGrid targets(nr_rows, nr_columns, [&](int i, int j) { return plan[i][j] == '.'; });
+
+        Grid<unsigned int> nr_coverable_cells(nr_rows, nr_columns);
+        CoverageCounter(walls, targets, header.router_radius)
+                .count_window(nr_coverable_cells, 0, 0, nr_rows - 1, nr_columns - 1, [&](int i, int j) { return plan[i][j] == '.'; });
+
+        const int max_score = (2 * header.router_radius + 1) * (2 * header.router_radius + 1) * 1000;
+        const auto score_gain = [&](int i, int j)
+        {
+            const int distance = max(abs(i - header.initial_row), abs(j - header.initial_column));
+            const int cost = header.router_cost + header.backbone_cost * distance;
+            return (int)nr_coverable_cells[i][j] * 1000 - cost;
+        };
+
+        cout << input_file << '\n' << right << setw(10) << "threads" << setw(16) << "mutex+set (ms)"
+             << setw(16) << "buffers (ms)" << setw(12) << "scaling" << setw(10) << "speedup" << '\n';
+        double single_thread_ms = 0;
+        constexpr int band_height = 16;
+        const int nr_bands = (nr_rows + band_height - 1) / band_height;
+        const auto for_each_candidate = [&](size_t band, auto&& push)
+        {
+            for (int i = (int)band * band_height; i < min(nr_rows, ((int)band + 1) * band_height); ++i)
+                for (int j = 0; j < nr_columns; ++j)
+                    if (plan[i][j] == '.' && score_gain(i, j) > 0)
+                        push(score_gain(i, j), Point{i, j});
+        };
+
+        for (const int nr_threads : thread_counts)
+        {
+            ThreadPool pool(nr_threads);
+            size_t legacy_size = 0, size = 0;
+
+            const double legacy_ms = best_time_ms([&]
+            {
+                legacy::ThreadSafePriorityQueue pq;
+                pool.parallel_for(0, nr_bands, 1, [&](size_t band)
+                {
+                    for_each_candidate(band, [&](int score, const Point& point) { pq.push({score, point}); });
+                });
+                legacy_size = pq.size();
+            });
+
+            const double buffers_ms = best_time_ms([&]
+            {
+                CandidateQueue pq(nr_rows, nr_columns, max_score);
+                pq.begin_bulk_push(nr_bands);
+                pool.parallel_for(0, nr_bands, 1, [&](size_t band)
+                {
+                    for_each_candidate(band, [&](int score, const Point& point) { pq.bulk_push(band, score, point); });
+                });
+                pq.end_bulk_push();
+                size = pq.size();
+            });
+
+            if (nr_threads == 1)
+                single_thread_ms = buffers_ms;
+            cout << setw(10) << nr_threads << fixed << setprecision(1) << setw(16) << legacy_ms << setw(16) << buffers_ms
+                 << setw(11) << setprecision(2) << single_thread_ms / buffers_ms << 'x' << setw(9) << legacy_ms / buffers_ms
+                 << 'x' << (size == legacy_size ? "" : " SIZE MISMATCH") << '\n';
+        }
+    }
+    return 0;
+}
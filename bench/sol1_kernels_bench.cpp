@@ -0,0 +1,133 @@
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "KernelBench.h"
+#include "../sol1/Data.h"
+#include "../sol1/Definitions.h"
+#include "../sol1/SegTree2D.h"
+#include "../sol1/CoverageCalculator.h"
+#include "../common/Grid.h"
+#include "../common/BitGrid.h"
+#include "../common/ThreadPool.h"
+
+using namespace std;
+
+/*
+ * sol1's kernels, one at a time on each input: loading, the coverage map (determine_coverage), the 2D segment tree
+ * over it (build, get_max, the best-first Cursor, update), and the per-router coverage count of the placement loop.
+ * The queries are the ones the solver makes: windows of radius 10, 13, ..., 61 around random cells, drawn from a
+ * fixed seed so that every run measures the same ones.
+ */
+
+constexpr size_t NR_QUERIES = 100000;
+constexpr size_t NR_CURSOR_QUERIES = 10000;
+constexpr unsigned int CANDIDATES_PER_CURSOR = 10;
+
+// The window of the given radius around 'middle', clamped to the map (as Solver::get_matrix)
+Matrix window_around(const Data& data, Point middle, unsigned int radius)
+{
+    const unsigned int upper_row = middle.first - min(middle.first, radius - 1);
+    const unsigned int upper_column = middle.second - min(middle.second, radius - 1);
+    const unsigned int lower_row = min(middle.first + radius - 1, data.nr_rows - 1);
+    const unsigned int lower_column = min(middle.second + radius - 1, data.nr_columns - 1);
+    return make_pair(make_pair(upper_row, upper_column), make_pair(lower_row, lower_column));
+}
+
+void run_fixture(const KernelBench& bench, const string& filename, const string& input_file)
+{
+    const Data data(filename);
+    const size_t nr_cells = (size_t)data.nr_rows * data.nr_columns;
+    KernelBench::print_fixture(input_file, data.nr_rows, data.nr_columns, data.router_radius);
+
+    bench.run("Data (mapped building plan)", 1, nr_cells, "cells", [&]
+    {
+        const Data loaded(filename);
+        do_not_optimize(loaded.building_plan[loaded.nr_rows - 1][loaded.nr_columns - 1]);
+    });
+
+    CoverageCalculator coverage_calculator(data);
+    bench.run_scaling("CoverageCalculator::determine_coverage", 1, nr_cells, "cells", [&](ThreadPool& pool)
+    {
+        const auto coverage = coverage_calculator.determine_coverage(pool);
+        do_not_optimize(coverage[0][0]);
+    });
+    const auto coverage = coverage_calculator.determine_coverage();
+
+    unique_ptr<SegTree2D> st;
+    bench.run("SegTree2D (build)", 1, nr_cells, "cells", [&]
+    {
+        st = make_unique<SegTree2D>(coverage, data.nr_rows, data.nr_columns);
+    });
+
+    // Random '.' cells, and the solver's windows around them
+    mt19937 generator(12345);
+    uniform_int_distribution<unsigned int> row_distribution(0, data.nr_rows - 1), column_distribution(0, data.nr_columns - 1);
+    uniform_int_distribution<unsigned int> radius_distribution(0, 17);
+    vector<Point> cells;
+    while (cells.size() < NR_QUERIES)
+    {
+        const Point cell = make_pair(row_distribution(generator), column_distribution(generator));
+        if (data.building_plan[cell.first][cell.second] == '.')
+            cells.push_back(cell);
+    }
+    vector<Matrix> windows;
+    for (const Point& cell : cells)
+        windows.push_back(window_around(data, cell, 10 + 3 * radius_distribution(generator)));
+
+    bench.run("SegTree2D::get_max", NR_QUERIES, NR_QUERIES, "queries", [&]
+    {
+        unsigned long long checksum = 0;
+        for (const Matrix& window : windows)
+            if (const auto best = st->get_max(window))
+                checksum += best.value().first;
+        do_not_optimize(checksum);
+    });
+
+    bench.run("SegTree2D::Cursor (best 10, radius 61)", NR_CURSOR_QUERIES, NR_CURSOR_QUERIES * CANDIDATES_PER_CURSOR, "candidates", [&]
+    {
+        unsigned long long checksum = 0;
+        for (size_t index = 0; index < NR_CURSOR_QUERIES; ++index)
+        {
+            SegTree2D::Cursor cursor(*st);
+            cursor.add(window_around(data, cells[index], 61));
+            for (unsigned int nr_candidates = 0; nr_candidates < CANDIDATES_PER_CURSOR; ++nr_candidates)
+                if (const auto candidate = cursor.next())
+                    checksum += candidate.value().first;
+        }
+        do_not_optimize(checksum);
+    });
+
+    bench.run("SegTree2D::update", NR_CURSOR_QUERIES, NR_CURSOR_QUERIES, "updates",
+              [&] { st = make_unique<SegTree2D>(coverage, data.nr_rows, data.nr_columns); }, [&]
+    {
+        for (size_t index = 0; index < NR_CURSOR_QUERIES; ++index)
+            st->update(cells[index]);
+    });
+
+    // Half the targets already covered, in stripes, as in the middle of a run
+    BitGrid is_covered(data.nr_rows, data.nr_columns, [&](unsigned int i, unsigned int j)
+    {
+        return (i / (2 * data.router_radius + 1)) % 2 == 0 && data.building_plan[i][j] == '.';
+    });
+    CoverageMask scratch;
+    bench.run("CoverageCalculator::count_covered_cells", NR_QUERIES, NR_QUERIES, "routers", [&]
+    {
+        unsigned long long checksum = 0;
+        for (const Point& cell : cells)
+            checksum += coverage_calculator.count_covered_cells(cell, scratch, &is_covered);
+        do_not_optimize(checksum);
+    });
+}
+
+int main(int argc, char** argv)
+{
+    const string in_prefix = input_prefix(argc, argv);
+    const KernelBench bench(argc, argv);
+
+    printf("hardware threads: %zu\n", ThreadPool::default_nr_threads());
+    for (const string& input_file : INPUT_FILES)
+        run_fixture(bench, in_prefix + input_file, input_file);
+    return 0;
+}
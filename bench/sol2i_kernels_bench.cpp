@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "KernelBench.h"
+#include "../sol2i/Data.h"
+#include "../sol2i/ComponentCalculator.h"
+#include "../common/BackboneIndex.h"
+#include "../common/BackboneMap.h"
+#include "../common/SpanningBackbone.h"
+
+using namespace std;
+
+/*
+ * sol2i's kernels, one at a time on each input: the components of perfect routers (get_components), then the
+ * backbone they are connected with: the nearest backbone queries of BackboneIndex (what the k-d trees used to
+ * answer), the greedy connection of SolutionProcessor::process, and the spanning tree it is rebuilt as.
+ */
+
+constexpr size_t NR_QUERIES = 100000;
+
+void run_fixture(const KernelBench& bench, const string& filename, const string& input_file)
+{
+    Data data(filename);
+    const size_t nr_cells = (size_t)data.nr_rows * data.nr_columns;
+    KernelBench::print_fixture(input_file, data.nr_rows, data.nr_columns, data.router_radius);
+
+    vector<vector<Point>> components;
+    bench.run("ComponentCalculator::get_components", 1, nr_cells, "cells", [&]
+    {
+        ComponentCalculator component_calculator(data);
+        components = component_calculator.get_components();
+    });
+    if (components.empty())
+        components = ComponentCalculator(data).get_components();
+
+    vector<Point> routers;
+    for (const auto& component : components)
+        routers.insert(routers.end(), component.begin(), component.end());
+
+    // Every router connected to the closest cable laid so far, as in SolutionProcessor::process (budget aside)
+    BackboneIndex backbone_index(data.nr_rows, data.nr_columns);
+    BackboneMap backbone;
+    const auto connect_routers = [&]
+    {
+        backbone_index = BackboneIndex(data.nr_rows, data.nr_columns);
+        backbone_index.insert(data.initial_cell);
+        backbone = BackboneMap(data.nr_rows, data.nr_columns);
+        backbone.insert(data.initial_cell.first, data.initial_cell.second);
+        for (const Point& router : routers)
+        {
+            const auto [nearest, distance] = backbone_index.find_nearest(router);
+            backbone.lay_cable(router.first, router.second, nearest.first, nearest.second);
+            backbone_index.insert_cable(router, nearest);
+        }
+    };
+    bench.run("BackboneIndex + BackboneMap (connect routers)", routers.size(), routers.size(), "routers", connect_routers);
+    connect_routers();
+
+    mt19937 generator(12345);
+    uniform_int_distribution<int> row_distribution(0, data.nr_rows - 1), column_distribution(0, data.nr_columns - 1);
+    vector<Point> cells;
+    for (size_t index = 0; index < NR_QUERIES; ++index)
+        cells.emplace_back(row_distribution(generator), column_distribution(generator));
+    bench.run("BackboneIndex::find_nearest", NR_QUERIES, NR_QUERIES, "queries", [&]
+    {
+        unsigned long long checksum = 0;
+        for (const Point& cell : cells)
+            checksum += backbone_index.find_nearest(cell).second;
+        do_not_optimize(checksum);
+    });
+
+    vector<Point> terminals{ data.initial_cell };
+    terminals.insert(terminals.end(), routers.begin(), routers.end());
+    bench.run("spanning_backbone::build", 1, terminals.size(), "terminals", [&]
+    {
+        const BackboneMap rebuilt = spanning_backbone::build(terminals, 0, data.nr_rows, data.nr_columns);
+        do_not_optimize(rebuilt.size());
+    });
+}
+
+int main(int argc, char** argv)
+{
+    const string in_prefix = input_prefix(argc, argv);
+    const KernelBench bench(argc, argv);
+
+    printf("hardware threads: %zu\n", ThreadPool::default_nr_threads());
+    for (const string& input_file : INPUT_FILES)
+        run_fixture(bench, in_prefix + input_file, input_file);
+    return 0;
+}
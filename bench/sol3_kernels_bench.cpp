@@ -0,0 +1,259 @@
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+#include "KernelBench.h"
+#include "../sol3/Data.h"
+#include "../sol3/ComponentCalculator.h"
+#include "../sol3/CandidateQueue.h"
+#include "../common/Grid.h"
+#include "../common/BitGrid.h"
+#include "../common/SummedAreaTable.h"
+#include "../common/CoverageKernel.h"
+#include "../common/CoverageCounter.h"
+#include "../common/ChebyshevDistanceMap.h"
+#include "../common/BackboneMap.h"
+#include "../common/ThreadPool.h"
+
+using namespace std;
+
+/*
+ * sol3's kernels, one at a time on each input: loading, the summed-area table, the perfect routers, the coverage
+ * counts (initialize_coverable_cells), the candidate queue (populate_pqueue_parallel), the update after placing a
+ * router (update_visited_and_coverage), laying cables, and the distance map to the backbone which answers the
+ * nearest backbone queries. The parallel ones are copies of the solver's, taking the pool to run on.
+ * The routers placed are the '.' cells of a lattice of pitch 2R + 1, in row-major order, like a perfect tiling.
+ */
+
+struct Fixture
+{
+    Data data;
+    BitGrid walls, targets;
+    CoverageKernel coverage_kernel;
+    vector<Point> routers;
+
+    explicit Fixture(const string& filename)
+    : data(filename)
+    , walls(data.nr_rows, data.nr_columns, [&](int i, int j) { return data.building_plan[i][j] == '#'; })
+    , targets(data.nr_rows, data.nr_columns, [&](int i, int j) { return data.building_plan[i][j] == '.'; })
+    , coverage_kernel(walls, targets, data.router_radius)
+    {
+        const int pitch = 2 * data.router_radius + 1;
+        for (int i = data.router_radius; i < data.nr_rows; i += pitch)
+            for (int j = data.router_radius; j < data.nr_columns; j += pitch)
+                if (data.building_plan[i][j] == '.')
+                    routers.emplace_back(i, j);
+    }
+
+    [[nodiscard]] size_t nr_cells() const
+    {
+        return (size_t)data.nr_rows * data.nr_columns;
+    }
+};
+
+void initialize_coverable_cells(ThreadPool& pool, const Fixture& fixture, const BitGrid& visited, Grid<unsigned int>& nr_coverable_cells)
+{
+    const Data& data = fixture.data;
+    const CoverageCounter counter(fixture.walls, fixture.targets, data.router_radius, &visited);
+    const auto can_place_router = [&](int i, int j) { return data.building_plan[i][j] == '.'; };
+
+    constexpr int band_height = 8;
+    const int nr_bands = (data.nr_rows + band_height - 1) / band_height;
+    pool.parallel_for(0, nr_bands, 1, [&](size_t band)
+    {
+        const int band_start = (int)band * band_height;
+        const int band_end = min(data.nr_rows, band_start + band_height) - 1;
+        counter.count_window(nr_coverable_cells, band_start, 0, band_end, data.nr_columns - 1, can_place_router);
+    });
+}
+
+void populate_pqueue_parallel(ThreadPool& pool, const Fixture& fixture, const Grid<unsigned int>& nr_coverable_cells,
+                              const ChebyshevDistanceMap& backbone_distance, CandidateQueue& pq)
+{
+    const Data& data = fixture.data;
+    constexpr int band_height = 16;
+    const int nr_bands = (data.nr_rows + band_height - 1) / band_height;
+    pq.begin_bulk_push(nr_bands);
+    pool.parallel_for(0, nr_bands, 1, [&](size_t band)
+    {
+        for (int i = (int)band * band_height; i < min(data.nr_rows, ((int)band + 1) * band_height); ++i)
+            for (int j = 0; j < data.nr_columns; ++j)
+            {
+                if (data.building_plan[i][j] != '.')
+                    continue;
+                const int cost = data.router_cost + data.backbone_cost * (int)backbone_distance.distance(i, j);
+                const int score_gain = (int)nr_coverable_cells[i][j] * 1000 - cost;
+                if (score_gain > 0 && cost <= data.budget)
+                    pq.bulk_push(band, score_gain, {i, j});
+            }
+    });
+    pq.end_bulk_push();
+}
+
+// Returns the number of cells newly covered by 'point'
+size_t update_visited_and_coverage(ThreadPool& pool, const Fixture& fixture, const Point& point, BitGrid& visited,
+                                   Grid<unsigned int>& nr_coverable_cells, vector<Point>& newly_covered_points)
+{
+    newly_covered_points.clear();
+    CoverageMask mask;
+    fixture.coverage_kernel.compute(point.first, point.second, mask, &visited);
+    mask.for_each_cell([&](int i, int j)
+    {
+        newly_covered_points.emplace_back(i, j);
+        visited.set(i, j);
+    });
+
+    constexpr size_t min_cells_per_task = 64;
+    pool.parallel_for_chunks(0, newly_covered_points.size(), min_cells_per_task, [&](size_t begin, size_t end)
+    {
+        CoverageMask seen_by;
+        for (size_t index = begin; index < end; ++index)
+        {
+            const auto [x, y] = newly_covered_points[index];
+            fixture.coverage_kernel.compute(x, y, seen_by);
+            seen_by.for_each_cell([&](int i, int j)
+            {
+                atomic_ref<unsigned int> nr_coverable(nr_coverable_cells[i][j]);
+                unsigned int current = nr_coverable.load(memory_order_relaxed);
+                while (current > 0 && !nr_coverable.compare_exchange_weak(current, current - 1, memory_order_relaxed));
+            });
+        }
+    });
+    return newly_covered_points.size();
+}
+
+void run_fixture(const KernelBench& bench, const string& filename, const string& input_file)
+{
+    Fixture fixture(filename);
+    const Data& data = fixture.data;
+    const size_t nr_cells = fixture.nr_cells();
+    const size_t nr_routers = fixture.routers.size();
+    KernelBench::print_fixture(input_file, data.nr_rows, data.nr_columns, data.router_radius);
+
+    bench.run("Data (mapped building plan)", 1, nr_cells, "cells", [&]
+    {
+        const Data loaded(filename);
+        do_not_optimize(loaded.building_plan[loaded.nr_rows - 1][loaded.nr_columns - 1]);
+    });
+
+    bench.run("SummedAreaTable (targets)", 1, nr_cells, "cells", [&]
+    {
+        const SummedAreaTable table(data.nr_rows, data.nr_columns, [&](int i, int j) { return data.building_plan[i][j] == '.'; });
+        do_not_optimize(table.rect_sum(0, 0, data.nr_rows - 1, data.nr_columns - 1));
+    });
+
+    BitGrid visited(data.nr_rows, data.nr_columns);
+    bench.run("ComponentCalculator::get_perfect_routers", 1, nr_cells, "cells", [&] { visited = BitGrid(data.nr_rows, data.nr_columns); }, [&]
+    {
+        ComponentCalculator component_calculator(data, visited);
+        do_not_optimize(component_calculator.get_perfect_routers().size());
+    });
+
+    const BitGrid nothing_visited(data.nr_rows, data.nr_columns);
+    Grid<unsigned int> nr_coverable_cells(data.nr_rows, data.nr_columns);
+    bench.run_scaling("initialize_coverable_cells", 1, nr_cells, "cells", [&](ThreadPool& pool)
+    {
+        initialize_coverable_cells(pool, fixture, nothing_visited, nr_coverable_cells);
+    });
+    initialize_coverable_cells(ThreadPool::global(), fixture, nothing_visited, nr_coverable_cells);
+
+    ChebyshevDistanceMap backbone_distance(data.nr_rows, data.nr_columns);
+    backbone_distance.add_sources(vector<Point>{ data.initial_cell });
+    const int max_score = (2 * data.router_radius + 1) * (2 * data.router_radius + 1) * 1000;
+    bench.run_scaling("populate_pqueue_parallel", 1, nr_cells, "cells", [&](ThreadPool& pool)
+    {
+        CandidateQueue pq(data.nr_rows, data.nr_columns, max_score);
+        populate_pqueue_parallel(pool, fixture, nr_coverable_cells, backbone_distance, pq);
+        do_not_optimize(pq.size());
+    });
+
+    // Every lattice router in turn, from the same initial counts each run
+    Grid<unsigned int> updated_coverable_cells(data.nr_rows, data.nr_columns);
+    vector<Point> newly_covered_points;
+    size_t nr_newly_covered = 0;
+    const auto reset_update = [&]
+    {
+        visited = BitGrid(data.nr_rows, data.nr_columns);
+        for (int i = 0; i < data.nr_rows; ++i)
+            copy_n(nr_coverable_cells[i], data.nr_columns, updated_coverable_cells[i]);
+    };
+    reset_update();
+    for (const Point& router : fixture.routers)
+        nr_newly_covered += update_visited_and_coverage(ThreadPool::global(), fixture, router, visited, updated_coverable_cells, newly_covered_points);
+    bench.run_scaling("update_visited_and_coverage", nr_routers, nr_newly_covered, "covered cells", reset_update, [&](ThreadPool& pool)
+    {
+        for (const Point& router : fixture.routers)
+            update_visited_and_coverage(pool, fixture, router, visited, updated_coverable_cells, newly_covered_points);
+    });
+
+    // Every lattice router connected to the previous one, starting from the initial cell
+    size_t nr_cable_cells = 0;
+    for (size_t index = 0; index < nr_routers; ++index)
+    {
+        const Point from = index ? fixture.routers[index - 1] : data.initial_cell;
+        nr_cable_cells += BackboneMap::cable_length(fixture.routers[index].first, fixture.routers[index].second, from.first, from.second);
+    }
+    BackboneMap backbone;
+    const auto lay_cables = [&]
+    {
+        backbone = BackboneMap(data.nr_rows, data.nr_columns);
+        backbone.insert(data.initial_cell.first, data.initial_cell.second);
+        for (size_t index = 0; index < nr_routers; ++index)
+        {
+            const Point from = index ? fixture.routers[index - 1] : data.initial_cell;
+            backbone.lay_cable(fixture.routers[index].first, fixture.routers[index].second, from.first, from.second);
+        }
+    };
+    bench.run("BackboneMap::lay_cable", nr_routers, nr_cable_cells, "cells", lay_cables);
+    lay_cables();
+    bench.run("BackboneMap::count_new_cells", nr_routers, nr_cable_cells, "cells", [&]
+    {
+        size_t nr_new_cells = 0;
+        for (size_t index = 1; index < nr_routers; ++index)
+        {
+            const Point& from = fixture.routers[index];
+            const Point& to = fixture.routers[nr_routers - index];
+            nr_new_cells += backbone.count_new_cells(from.first, from.second, to.first, to.second);
+        }
+        do_not_optimize(nr_new_cells);
+    });
+
+    // The nearest backbone cell of every '.' cell, the backbone being the cables above
+    bench.run("ChebyshevDistanceMap::build", 1, nr_cells, "cells", [&]
+    {
+        backbone_distance.build([&](int i, int j) { return backbone.contains(i, j); });
+    });
+    const size_t nr_targets = fixture.targets.count_in_window(0, 0, data.nr_rows - 1, data.nr_columns - 1);
+    bench.run("ChebyshevDistanceMap::nearest", nr_targets, nr_targets, "queries", [&]
+    {
+        long long checksum = 0;
+        for (int i = 0; i < data.nr_rows; ++i)
+            for (int j = 0; j < data.nr_columns; ++j)
+                if (data.building_plan[i][j] == '.')
+                    checksum += backbone_distance.nearest(i, j).first;
+        do_not_optimize(checksum);
+    });
+
+    // The routers added one at a time as new sources, as the solver does after every placement
+    bench.run("ChebyshevDistanceMap::add_sources", nr_routers, nr_routers, "sources", [&]
+    {
+        backbone_distance = ChebyshevDistanceMap(data.nr_rows, data.nr_columns);
+        backbone_distance.add_sources(vector<Point>{ data.initial_cell });
+    }, [&]
+    {
+        for (const Point& router : fixture.routers)
+            backbone_distance.add_sources(array<Point, 1>{ router });
+    });
+}
+
+int main(int argc, char** argv)
+{
+    const string in_prefix = input_prefix(argc, argv);
+    const KernelBench bench(argc, argv);
+
+    printf("hardware threads: %zu\n", ThreadPool::default_nr_threads());
+    for (const string& input_file : INPUT_FILES)
+        run_fixture(bench, in_prefix + input_file, input_file);
+    return 0;
+}
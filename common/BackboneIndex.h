@@ -0,0 +1,205 @@
+#pragma once
+/*
+ * Nearest backbone cell queries (under Chebyshev distance) over a backbone stored as segments.
+ * A cable between two cells is a straight run followed by a diagonal run, so it is stored as (at most) two
+ * segments instead of one entry per cell. Segments are registered in the buckets of a uniform grid they pass
+ * through, as nodes of singly linked lists kept in one arena vector. A query scans rings of buckets around the
+ * point, evaluating each segment exactly, until no farther ring can hold anything closer.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+class BackboneIndex
+{
+private:
+    using Cell = std::pair<int, int>;
+
+    static constexpr int BUCKET_SIZE = 16;
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // The cells start + t * step, for t in [0, length]
+    struct Segment
+    {
+        int start_i, start_j;
+        int step_i, step_j;
+        int length;
+    };
+
+    struct Node
+    {
+        uint32_t segment;
+        uint32_t next;
+    };
+
+    int bucket_rows, bucket_columns;
+    std::vector<Segment> segments;
+    // Last query that evaluated each segment, so that a segment spanning several buckets is evaluated once
+    std::vector<uint32_t> evaluated_by;
+    uint32_t query_stamp = 0;
+    std::vector<Node> arena;
+    std::vector<uint32_t> bucket_head;
+
+    uint32_t& head(int bucket_i, int bucket_j)
+    {
+        return bucket_head[bucket_i * bucket_columns + bucket_j];
+    }
+
+    void add_segment(int start_i, int start_j, int step_i, int step_j, int length)
+    {
+        const uint32_t id = segments.size();
+        segments.push_back({start_i, start_j, step_i, step_j, length});
+        evaluated_by.push_back(0);
+
+        // The runs are monotone, so a bucket is never entered twice
+        int previous_bucket = -1;
+        for (int t = 0; t <= length; ++t)
+        {
+            const int bucket_i = (start_i + t * step_i) / BUCKET_SIZE, bucket_j = (start_j + t * step_j) / BUCKET_SIZE;
+            const int bucket = bucket_i * bucket_columns + bucket_j;
+            if (bucket == previous_bucket)
+                continue;
+            previous_bucket = bucket;
+
+            arena.push_back({id, bucket_head[bucket]});
+            bucket_head[bucket] = arena.size() - 1;
+        }
+    }
+
+    // Closest cell of 'segment' to (i, j), and its distance
+    static std::pair<unsigned int, Cell> closest_cell(const Segment& segment, int i, int j)
+    {
+        const auto distance_at = [&](int t)
+        {
+            return (unsigned int)std::max(std::abs(i - (segment.start_i + t * segment.step_i)),
+                                          std::abs(j - (segment.start_j + t * segment.step_j)));
+        };
+
+        // Each coordinate distance is either constant or |t - c|, so the max of both is convex in t, and it is
+        // minimal at an end, at one of the c's, or around their midpoint
+        const int center_i = (i - segment.start_i) * segment.step_i, center_j = (j - segment.start_j) * segment.step_j;
+        const int candidates[] = { 0, segment.length, center_i, center_j,
+                                   (center_i + center_j) / 2, (center_i + center_j + 1) / 2 };
+
+        unsigned int best_distance = UINT_MAX;
+        int best_t = 0;
+        for (int t : candidates)
+        {
+            t = std::clamp(t, 0, segment.length);
+            if (const unsigned int distance = distance_at(t); distance < best_distance)
+            {
+                best_distance = distance;
+                best_t = t;
+            }
+        }
+        return {best_distance, {segment.start_i + best_t * segment.step_i, segment.start_j + best_t * segment.step_j}};
+    }
+
+public:
+
+    BackboneIndex(int nr_rows, int nr_columns)
+    : bucket_rows((nr_rows + BUCKET_SIZE - 1) / BUCKET_SIZE)
+    , bucket_columns((nr_columns + BUCKET_SIZE - 1) / BUCKET_SIZE)
+    , bucket_head((size_t)bucket_rows * bucket_columns, NONE)
+    {
+    }
+
+    // Adds a single backbone cell
+    void insert(const Cell& cell)
+    {
+        add_segment(cell.first, cell.second, 0, 0, 0);
+    }
+
+    // Adds the cable from 'from' to 'to': along the dominant axis until both offsets are equal, then diagonally
+    // (the path BackboneMap::for_each_cable_cell walks)
+    void insert_cable(const Cell& from, const Cell& to)
+    {
+        const int delta_i = to.first - from.first, delta_j = to.second - from.second;
+        const int step_i = (delta_i > 0) - (delta_i < 0), step_j = (delta_j > 0) - (delta_j < 0);
+        const int straight = std::abs(std::abs(delta_i) - std::abs(delta_j));
+        const int diagonal = std::min(std::abs(delta_i), std::abs(delta_j));
+
+        if (std::abs(delta_i) > std::abs(delta_j))
+            add_segment(from.first, from.second, step_i, 0, straight);
+        else
+            add_segment(from.first, from.second, 0, step_j, straight);
+
+        if (diagonal > 0)
+        {
+            const int corner_i = to.first - diagonal * step_i, corner_j = to.second - diagonal * step_j;
+            add_segment(corner_i, corner_j, step_i, step_j, diagonal);
+        }
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return segments.empty();
+    }
+
+    [[nodiscard]] size_t nr_segments() const
+    {
+        return segments.size();
+    }
+
+    // Number of (segment, bucket) entries
+    [[nodiscard]] size_t nr_nodes() const
+    {
+        return arena.size();
+    }
+
+    // Closest backbone cell to 'cell', and its Chebyshev distance; the index must not be empty
+    std::pair<Cell, unsigned int> find_nearest(const Cell& cell)
+    {
+        ++query_stamp;
+        const int bucket_i = cell.first / BUCKET_SIZE, bucket_j = cell.second / BUCKET_SIZE;
+        const int max_ring = std::max({ bucket_i, bucket_rows - 1 - bucket_i, bucket_j, bucket_columns - 1 - bucket_j });
+
+        unsigned int best_distance = UINT_MAX;
+        Cell best_cell = cell;
+        for (int ring = 0; ring <= max_ring; ++ring)
+        {
+            // Every cell of a bucket 'ring' buckets away is at least this far
+            const unsigned int lower_bound = ring ? (ring - 1) * BUCKET_SIZE + 1 : 0;
+            if (best_distance <= lower_bound)
+                break;
+
+            const auto visit = [&](int x, int y)
+            {
+                for (uint32_t node = head(x, y); node != NONE; node = arena[node].next)
+                {
+                    const uint32_t id = arena[node].segment;
+                    if (evaluated_by[id] == query_stamp)
+                        continue;
+                    evaluated_by[id] = query_stamp;
+
+                    const auto [distance, closest] = closest_cell(segments[id], cell.first, cell.second);
+                    if (distance < best_distance)
+                    {
+                        best_distance = distance;
+                        best_cell = closest;
+                    }
+                }
+            };
+
+            // Only the border of the ring
+            for (int x = std::max(0, bucket_i - ring); x <= std::min(bucket_rows - 1, bucket_i + ring); ++x)
+            {
+                if (x == bucket_i - ring || x == bucket_i + ring)
+                    for (int y = std::max(0, bucket_j - ring); y <= std::min(bucket_columns - 1, bucket_j + ring); ++y)
+                        visit(x, y);
+                else
+                {
+                    if (bucket_j - ring >= 0)
+                        visit(x, bucket_j - ring);
+                    if (bucket_j + ring < bucket_columns)
+                        visit(x, bucket_j + ring);
+                }
+            }
+        }
+        return {best_cell, best_distance};
+    }
+};
@@ -0,0 +1,162 @@
+#pragma once
+/*
+ * The backbone as a bitmap, with its number of cells kept up to date.
+ * Cables are laid in closed form: from one end, straight along the axis with the larger offset until both offsets
+ * are equal, then diagonally. This is a shortest Chebyshev path, the same one the solutions used to build a cell
+ * at a time by trying all 8 neighbours, and laying it reports how many cells were new, which is the exact cost.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdlib>
+#include <ostream>
+
+#include "BitGrid.h"
+
+class BackboneMap
+{
+private:
+    BitGrid cells;
+    size_t nr_cells = 0;
+
+public:
+
+    BackboneMap() = default;
+
+    BackboneMap(size_t nr_rows, size_t nr_columns)
+    : cells(nr_rows, nr_columns)
+    {
+    }
+
+    // Calls f(i, j) for every cell of the cable from (from_i, from_j) to (to_i, to_j), both ends included, in order
+    template <typename Function>
+    static void for_each_cable_cell(int from_i, int from_j, int to_i, int to_j, Function&& f)
+    {
+        const int delta_i = to_i - from_i, delta_j = to_j - from_j;
+        const int step_i = (delta_i > 0) - (delta_i < 0), step_j = (delta_j > 0) - (delta_j < 0);
+        const int straight = std::abs(std::abs(delta_i) - std::abs(delta_j));
+        const int diagonal = std::min(std::abs(delta_i), std::abs(delta_j));
+        const bool along_rows = std::abs(delta_i) > std::abs(delta_j);
+
+        int i = from_i, j = from_j;
+        f(i, j);
+        for (int step = 0; step < straight; ++step)
+        {
+            if (along_rows)
+                i += step_i;
+            else
+                j += step_j;
+            f(i, j);
+        }
+        for (int step = 0; step < diagonal; ++step)
+        {
+            i += step_i;
+            j += step_j;
+            f(i, j);
+        }
+    }
+
+    // Length of the cable between two cells, ends included
+    static size_t cable_length(int from_i, int from_j, int to_i, int to_j)
+    {
+        return std::max(std::abs(to_i - from_i), std::abs(to_j - from_j)) + 1;
+    }
+
+    [[nodiscard]] bool contains(int i, int j) const
+    {
+        return cells.test(i, j);
+    }
+
+    // Returns whether the cell is new
+    bool insert(int i, int j)
+    {
+        if (cells.test(i, j))
+            return false;
+        cells.set(i, j);
+        nr_cells++;
+        return true;
+    }
+
+    void erase(int i, int j)
+    {
+        if (cells.test(i, j))
+        {
+            cells.reset(i, j);
+            nr_cells--;
+        }
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return nr_cells;
+    }
+
+    // Number of cells a cable would add, i.e. the ones not on the backbone yet
+    [[nodiscard]] size_t count_new_cells(int from_i, int from_j, int to_i, int to_j) const
+    {
+        size_t count = 0;
+        for_each_cable_cell(from_i, from_j, to_i, to_j, [&](int i, int j) { count += !cells.test(i, j); });
+        return count;
+    }
+
+    // Lays a cable, calls on_new_cell(i, j) for every cell it adds, and returns how many it added
+    template <typename OnNewCell>
+    size_t lay_cable(int from_i, int from_j, int to_i, int to_j, OnNewCell&& on_new_cell)
+    {
+        const size_t old_size = nr_cells;
+        for_each_cable_cell(from_i, from_j, to_i, to_j, [&](int i, int j)
+        {
+            if (insert(i, j))
+                on_new_cell(i, j);
+        });
+        return nr_cells - old_size;
+    }
+
+    size_t lay_cable(int from_i, int from_j, int to_i, int to_j)
+    {
+        return lay_cable(from_i, from_j, to_i, to_j, [](int, int) {});
+    }
+
+    // Calls f(i, j) for every cell, in row-major order
+    template <typename Function>
+    void for_each_cell(Function&& f) const
+    {
+        for (size_t i = 0; i < cells.rows(); ++i)
+        {
+            const uint64_t* row = cells.row(i);
+            for (size_t word = 0; word < cells.words_per_row(); ++word)
+                for (uint64_t bits = row[word]; bits; bits &= bits - 1)
+                    f((int)i, (int)(word * 64 + std::countr_zero(bits)));
+        }
+    }
+
+    // Writes the number of cells, then one "row column" line per cell, in row-major order
+    void write(std::ostream& out) const
+    {
+        // Formatted a chunk at a time, without going through the stream for every number
+        char buffer[1 << 16];
+        char* const buffer_end = buffer + sizeof(buffer);
+        char* end = buffer;
+        const auto append = [&](size_t value, char separator)
+        {
+            // A number and its separator always fit in 32 bytes: flush when less is left
+            if (buffer_end - end < 32)
+            {
+                out.write(buffer, end - buffer);
+                end = buffer;
+            }
+            // The last byte is kept for the separator, so that both writes are visibly within the buffer
+            end = std::to_chars(end, buffer_end - 1, value).ptr;
+            *end++ = separator;
+        };
+
+        append(nr_cells, '\n');
+        for_each_cell([&](int i, int j)
+        {
+            append(i, ' ');
+            append(j, '\n');
+        });
+        out.write(buffer, end - buffer);
+    }
+};
@@ -0,0 +1,203 @@
+#pragma once
+/*
+ * Bit-packed boolean grid: 64 cells per word, every row starting on its own cache line.
+ * Window queries (count / any / for-each) work a whole word at a time with popcount and masks.
+ */
+
+#include <bit>
+#include <cstdint>
+
+#include "Grid.h"
+
+class BitGrid
+{
+private:
+    size_t nr_rows = 0, nr_columns = 0;
+    Grid<uint64_t> words;
+
+    static constexpr size_t WORD_BITS = 64;
+
+    // Bits [first, last] of a word, both inclusive and in [0, 63]
+    static uint64_t bit_range(size_t first, size_t last)
+    {
+        const uint64_t up_to_last = (last == WORD_BITS - 1) ? ~0ull : ((1ull << (last + 1)) - 1);
+        return up_to_last & (~0ull << first);
+    }
+
+    // Calls f(word_index, mask) for every word touched by the columns [j1, j2] of a row
+    template <typename Function>
+    static void for_each_word(size_t j1, size_t j2, Function&& f)
+    {
+        const size_t first_word = j1 / WORD_BITS, last_word = j2 / WORD_BITS;
+        if (first_word == last_word)
+        {
+            f(first_word, bit_range(j1 % WORD_BITS, j2 % WORD_BITS));
+            return;
+        }
+
+        f(first_word, bit_range(j1 % WORD_BITS, WORD_BITS - 1));
+        for (size_t word = first_word + 1; word < last_word; ++word)
+            f(word, ~0ull);
+        f(last_word, bit_range(0, j2 % WORD_BITS));
+    }
+
+public:
+
+    BitGrid() = default;
+
+    BitGrid(size_t nr_rows, size_t nr_columns, bool value = false)
+    : nr_rows(nr_rows)
+    , nr_columns(nr_columns)
+    , words(nr_rows, (nr_columns + WORD_BITS - 1) / WORD_BITS, 0)
+    {
+        if (value)
+            for (size_t i = 0; i < nr_rows; ++i)
+                set_window(i, 0, i, nr_columns - 1);
+    }
+
+    // Sets the cells for which is_set(i, j) holds
+    template <typename Predicate>
+    BitGrid(size_t nr_rows, size_t nr_columns, Predicate&& is_set)
+    : BitGrid(nr_rows, nr_columns)
+    {
+        for (size_t i = 0; i < nr_rows; ++i)
+        {
+            uint64_t* row_words = words[i];
+            for (size_t j = 0; j < nr_columns; ++j)
+                if (is_set(i, j))
+                    row_words[j / WORD_BITS] |= 1ull << (j % WORD_BITS);
+        }
+    }
+
+    [[nodiscard]] size_t rows() const
+    {
+        return nr_rows;
+    }
+
+    [[nodiscard]] size_t columns() const
+    {
+        return nr_columns;
+    }
+
+    [[nodiscard]] size_t words_per_row() const
+    {
+        return words.columns();
+    }
+
+    [[nodiscard]] const uint64_t* row(size_t i) const
+    {
+        return words[i];
+    }
+
+    uint64_t* row(size_t i)
+    {
+        return words[i];
+    }
+
+    // The 64 cells of row i starting at column 'first' (which may be negative); cells outside the row read as 0
+    [[nodiscard]] uint64_t word_at(size_t i, long first) const
+    {
+        const uint64_t* row_words = words[i];
+        const long nr_words = (long)words.columns();
+        const auto word_or_zero = [&](long word) { return (word >= 0 && word < nr_words) ? row_words[word] : 0ull; };
+
+        const long word = (first >= 0) ? first / (long)WORD_BITS : -((-first + (long)WORD_BITS - 1) / (long)WORD_BITS);
+        const unsigned int shift = first - word * (long)WORD_BITS;
+        if (shift == 0)
+            return word_or_zero(word);
+        return (word_or_zero(word) >> shift) | (word_or_zero(word + 1) << (WORD_BITS - shift));
+    }
+
+    [[nodiscard]] bool test(size_t i, size_t j) const
+    {
+        return (words[i][j / WORD_BITS] >> (j % WORD_BITS)) & 1;
+    }
+
+    void set(size_t i, size_t j)
+    {
+        words[i][j / WORD_BITS] |= 1ull << (j % WORD_BITS);
+    }
+
+    void reset(size_t i, size_t j)
+    {
+        words[i][j / WORD_BITS] &= ~(1ull << (j % WORD_BITS));
+    }
+
+    // Sets every cell of the window [(i1, j1), (i2, j2)], both corners inclusive
+    void set_window(size_t i1, size_t j1, size_t i2, size_t j2)
+    {
+        for (size_t i = i1; i <= i2; ++i)
+        {
+            uint64_t* row_words = words[i];
+            for_each_word(j1, j2, [&](size_t word, uint64_t mask) { row_words[word] |= mask; });
+        }
+    }
+
+    // Number of set cells in the window [(i1, j1), (i2, j2)]
+    [[nodiscard]] size_t count_in_window(size_t i1, size_t j1, size_t i2, size_t j2) const
+    {
+        size_t count = 0;
+        for (size_t i = i1; i <= i2; ++i)
+        {
+            const uint64_t* row_words = words[i];
+            for_each_word(j1, j2, [&](size_t word, uint64_t mask) { count += std::popcount(row_words[word] & mask); });
+        }
+        return count;
+    }
+
+    // Number of cells in the window which are set here but not in 'excluded' (e.g. targets not yet covered)
+    [[nodiscard]] size_t count_in_window(size_t i1, size_t j1, size_t i2, size_t j2, const BitGrid& excluded) const
+    {
+        size_t count = 0;
+        for (size_t i = i1; i <= i2; ++i)
+        {
+            const uint64_t* row_words = words[i];
+            const uint64_t* excluded_words = excluded.words[i];
+            for_each_word(j1, j2, [&](size_t word, uint64_t mask)
+            {
+                count += std::popcount(row_words[word] & ~excluded_words[word] & mask);
+            });
+        }
+        return count;
+    }
+
+    [[nodiscard]] bool any_in_window(size_t i1, size_t j1, size_t i2, size_t j2) const
+    {
+        for (size_t i = i1; i <= i2; ++i)
+        {
+            const uint64_t* row_words = words[i];
+            bool found = false;
+            for_each_word(j1, j2, [&](size_t word, uint64_t mask) { found |= (row_words[word] & mask) != 0; });
+            if (found)
+                return true;
+        }
+        return false;
+    }
+
+    [[nodiscard]] bool any_in_window(size_t i1, size_t j1, size_t i2, size_t j2, const BitGrid& excluded) const
+    {
+        for (size_t i = i1; i <= i2; ++i)
+        {
+            const uint64_t* row_words = words[i];
+            const uint64_t* excluded_words = excluded.words[i];
+            bool found = false;
+            for_each_word(j1, j2, [&](size_t word, uint64_t mask) { found |= (row_words[word] & ~excluded_words[word] & mask) != 0; });
+            if (found)
+                return true;
+        }
+        return false;
+    }
+
+    // Calls f(j) for every column j in [j1, j2] of row i which is set here but not in 'excluded'
+    template <typename Function>
+    void for_each_in_row(size_t i, size_t j1, size_t j2, const BitGrid& excluded, Function&& f) const
+    {
+        const uint64_t* row_words = words[i];
+        const uint64_t* excluded_words = excluded.words[i];
+        for_each_word(j1, j2, [&](size_t word, uint64_t mask)
+        {
+            for (uint64_t bits = row_words[word] & ~excluded_words[word] & mask; bits; bits &= bits - 1)
+                f(word * WORD_BITS + std::countr_zero(bits));
+        });
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+/*
+ * Zero-copy loader for the building plan (.in) files.
+ * The header is parsed in place, and the grid is exposed as a strided view over the rows of the
+ * mapped file, so building_plan[i][j] reads straight from the page cache.
+ */
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <vector>
+
+#include "MappedFile.h"
+
+struct PlanHeader
+{
+    int nr_rows = 0, nr_columns = 0, router_radius = 0;
+    int backbone_cost = 0, router_cost = 0, budget = 0;
+    int initial_row = 0, initial_column = 0;
+};
+
+class BuildingPlan
+{
+private:
+    MappedFile file;
+    PlanHeader plan_header;
+    const char* first_row = nullptr;
+    size_t stride = 0;
+
+    // Only used when the rows are not evenly spaced in the file (e.g. trailing whitespace)
+    std::vector<char> compacted_rows;
+
+    static bool is_blank(char c)
+    {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    static size_t parse_int(std::string_view text, size_t pos, int& value)
+    {
+        while (pos < text.size() && is_blank(text[pos]))
+            ++pos;
+
+        const auto [end, error] = std::from_chars(text.data() + pos, text.data() + text.size(), value);
+        if (error != std::errc())
+            throw std::runtime_error("Malformed building plan header");
+        return end - text.data();
+    }
+
+    bool rows_are_evenly_spaced(std::string_view text, size_t start)
+    {
+        // A row is terminated by "\n" or "\r\n"; the first row tells which one is used
+        const size_t first_newline = start + plan_header.nr_columns;
+        if (first_newline >= text.size())
+            return plan_header.nr_rows == 1 && first_newline == text.size();
+
+        const size_t terminator_length = (text[first_newline] == '\r') ? 2 : 1;
+        stride = plan_header.nr_columns + terminator_length;
+
+        const size_t last_row_end = start + (plan_header.nr_rows - 1) * stride + plan_header.nr_columns;
+        if (last_row_end > text.size())
+            return false;
+
+        for (int i = 0; i + 1 < plan_header.nr_rows; ++i)
+        {
+            const size_t row_end = start + i * stride + plan_header.nr_columns;
+            if (text[row_end + terminator_length - 1] != '\n' || (terminator_length == 2 && text[row_end] != '\r'))
+                return false;
+        }
+        return true;
+    }
+
+    void compact_rows(std::string_view text, size_t pos)
+    {
+        // Same semantics as reading the plan char by char through operator >>: whitespace is skipped
+        const size_t nr_cells = (size_t)plan_header.nr_rows * plan_header.nr_columns;
+        compacted_rows.reserve(nr_cells);
+        for (; pos < text.size() && compacted_rows.size() < nr_cells; ++pos)
+            if (!is_blank(text[pos]))
+                compacted_rows.push_back(text[pos]);
+
+        if (compacted_rows.size() != nr_cells)
+            throw std::runtime_error("Building plan is smaller than its header states");
+
+        first_row = compacted_rows.data();
+        stride = plan_header.nr_columns;
+    }
+
+public:
+
+    explicit BuildingPlan(const std::string& filename): file(filename)
+    {
+        const std::string_view text = file.contents();
+
+        size_t pos = 0;
+        for (int* field : { &plan_header.nr_rows, &plan_header.nr_columns, &plan_header.router_radius,
+                            &plan_header.backbone_cost, &plan_header.router_cost, &plan_header.budget,
+                            &plan_header.initial_row, &plan_header.initial_column })
+            pos = parse_int(text, pos, *field);
+
+        // Skipping the rest of the third line
+        while (pos < text.size() && text[pos] != '\n')
+            ++pos;
+        ++pos;
+
+        if (rows_are_evenly_spaced(text, pos))
+            first_row = text.data() + pos;
+        else
+            compact_rows(text, pos);
+    }
+
+    BuildingPlan(const BuildingPlan&) = delete;
+    BuildingPlan& operator=(const BuildingPlan&) = delete;
+
+    [[nodiscard]] const PlanHeader& header() const
+    {
+        return plan_header;
+    }
+
+    [[nodiscard]] int rows() const
+    {
+        return plan_header.nr_rows;
+    }
+
+    [[nodiscard]] int columns() const
+    {
+        return plan_header.nr_columns;
+    }
+
+    const char* operator[](size_t row) const
+    {
+        return first_row + row * stride;
+    }
+};
@@ -0,0 +1,135 @@
+#pragma once
+/*
+ * Chebyshev distance from every cell to the closest source cell (e.g. the backbone), and which source that is.
+ * build() runs the classic two-pass distance transform: with unit steps to all 8 neighbours, a forward pass
+ * looking up/left and a backward pass looking down/right are exact for the Chebyshev metric. add_sources()
+ * keeps the map exact as sources are added, with a breadth-first wavefront from the new sources that stops
+ * wherever it no longer improves a cell, so it only touches the cells which got closer.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Grid.h"
+
+class ChebyshevDistanceMap
+{
+private:
+    static constexpr unsigned int UNREACHED = UINT_MAX;
+
+    int nr_rows, nr_columns;
+    Grid<unsigned int> distance_to;
+    // Closest source of every cell, as row * nr_columns + column
+    Grid<uint32_t> nearest_source;
+    std::vector<uint32_t> wavefront;
+
+    // Takes the source of (from_i, from_j) for (i, j) if it is closer that way
+    void relax(int i, int j, int from_i, int from_j)
+    {
+        const unsigned int through = distance_to[from_i][from_j];
+        if (through != UNREACHED && through + 1 < distance_to[i][j])
+        {
+            distance_to[i][j] = through + 1;
+            nearest_source[i][j] = nearest_source[from_i][from_j];
+        }
+    }
+
+public:
+
+    // A map with no sources yet
+    ChebyshevDistanceMap(int nr_rows, int nr_columns)
+    : nr_rows(nr_rows)
+    , nr_columns(nr_columns)
+    , distance_to(nr_rows, nr_columns, UNREACHED)
+    , nearest_source(nr_rows, nr_columns, 0)
+    {
+    }
+
+    // Rebuilds the map from scratch, with the cells for which is_source(i, j) holds as sources
+    template <typename IsSource>
+    void build(IsSource&& is_source)
+    {
+        for (int i = 0; i < nr_rows; ++i)
+            for (int j = 0; j < nr_columns; ++j)
+            {
+                distance_to[i][j] = is_source(i, j) ? 0 : UNREACHED;
+                nearest_source[i][j] = i * nr_columns + j;
+            }
+
+        for (int i = 0; i < nr_rows; ++i)
+            for (int j = 0; j < nr_columns; ++j)
+            {
+                if (j > 0)
+                    relax(i, j, i, j - 1);
+                if (i > 0)
+                    for (int dj = -1; dj <= 1; ++dj)
+                        if (j + dj >= 0 && j + dj < nr_columns)
+                            relax(i, j, i - 1, j + dj);
+            }
+
+        for (int i = nr_rows - 1; i >= 0; --i)
+            for (int j = nr_columns - 1; j >= 0; --j)
+            {
+                if (j < nr_columns - 1)
+                    relax(i, j, i, j + 1);
+                if (i < nr_rows - 1)
+                    for (int dj = -1; dj <= 1; ++dj)
+                        if (j + dj >= 0 && j + dj < nr_columns)
+                            relax(i, j, i + 1, j + dj);
+            }
+    }
+
+    // Adds the (i, j) cells of 'sources' as sources, and calls on_closer(i, j) once for every cell whose
+    // distance went down (the new sources included)
+    template <typename Cells, typename OnCloser>
+    void add_sources(const Cells& sources, OnCloser&& on_closer)
+    {
+        wavefront.clear();
+        for (const auto& [i, j] : sources)
+            if (distance_to[i][j] != 0)
+            {
+                distance_to[i][j] = 0;
+                nearest_source[i][j] = i * nr_columns + j;
+                wavefront.push_back(i * nr_columns + j);
+                on_closer(i, j);
+            }
+
+        // Breadth-first, so every cell is reached first at its final distance
+        for (size_t head = 0; head < wavefront.size(); ++head)
+        {
+            const int i = wavefront[head] / nr_columns, j = wavefront[head] % nr_columns;
+            const unsigned int next_distance = distance_to[i][j] + 1;
+
+            for (int x = std::max(0, i - 1); x <= std::min(nr_rows - 1, i + 1); ++x)
+                for (int y = std::max(0, j - 1); y <= std::min(nr_columns - 1, j + 1); ++y)
+                    if (next_distance < distance_to[x][y])
+                    {
+                        distance_to[x][y] = next_distance;
+                        nearest_source[x][y] = nearest_source[i][j];
+                        wavefront.push_back(x * nr_columns + y);
+                        on_closer(x, y);
+                    }
+        }
+    }
+
+    template <typename Cells>
+    void add_sources(const Cells& sources)
+    {
+        add_sources(sources, [](int, int) {});
+    }
+
+    // UINT_MAX while there are no sources
+    [[nodiscard]] unsigned int distance(int i, int j) const
+    {
+        return distance_to[i][j];
+    }
+
+    // Closest source to (i, j); only meaningful once there is a source
+    [[nodiscard]] std::pair<int, int> nearest(int i, int j) const
+    {
+        return {(int)(nearest_source[i][j] / nr_columns), (int)(nearest_source[i][j] % nr_columns)};
+    }
+};
@@ -0,0 +1,295 @@
+#pragma once
+/*
+ * Coverage count for every candidate position of a map, in O(N * M * R) instead of O(N * M * R^2).
+ * For a router at (i, j), the cells of row x that it covers on its right are the targets in [j, b - 1], where b
+ * is the first column >= j having a wall in rows [i, x] (and symmetrically on its left). So for a fixed router
+ * row i, the "wall somewhere in rows [i, x]" state of every column is one running OR of wall bitplane rows, shared
+ * by all the routers of row i. The routers of one run of unblocked columns share its ends (two bit scans), and
+ * each router's count for the row is the popcount of the countable target bitplane over its part of the run.
+ * Both steps of a row, the folding and the counting, are dispatched on the CPU: with AVX2 the folding is done 256
+ * bits at a time and the counting with the POPCNT instruction, otherwise 64 bits at a time with a portable popcount.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "BitGrid.h"
+#include "Grid.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COVERAGE_COUNTER_HAS_AVX2 1
+#endif
+
+enum class CoverageIsa { Scalar, Avx2 };
+
+namespace coverage_simd
+{
+    constexpr int WORD_BITS = 64;
+
+    // One row x of a sweep: the routers still open, the columns blocked between their row and x, the countable
+    // targets of row x, and the totals they are added to. Words are relative to the first column of the sweep.
+    struct RowCount
+    {
+        const uint64_t* open;
+        const uint64_t* blocked;
+        const uint64_t* countable;
+        int nr_words, word_offset;
+        int radius, nr_columns;
+        // totals[j - first_total] is the count of the router in column j
+        unsigned int* totals;
+        int first_total;
+    };
+
+    // First set bit at or after 'from' of a bit row of 'nr_words' words, or nr_words * 64 if there is none
+    inline int next_set_bit(const uint64_t* words, int nr_words, int from)
+    {
+        int word = from / WORD_BITS;
+        uint64_t bits = words[word] & (~0ull << (from % WORD_BITS));
+        while (!bits)
+        {
+            if (++word == nr_words)
+                return nr_words * WORD_BITS;
+            bits = words[word];
+        }
+        return word * WORD_BITS + std::countr_zero(bits);
+    }
+
+    // Last set bit at or before 'from' of a bit row, or -1 if there is none
+    inline int previous_set_bit(const uint64_t* words, int from)
+    {
+        int word = from / WORD_BITS;
+        const int shift = WORD_BITS - 1 - from % WORD_BITS;
+        uint64_t bits = (words[word] << shift) >> shift;
+        while (!bits)
+        {
+            if (--word < 0)
+                return -1;
+            bits = words[word];
+        }
+        return word * WORD_BITS + WORD_BITS - 1 - std::countl_zero(bits);
+    }
+
+    // Number of set bits in [first, last] of a bit row, which must have a word to spare after 'last'; inlined in
+    // each dispatched function, so that std::popcount is compiled for its instruction set
+    [[gnu::always_inline]] inline unsigned int count_bits(const uint64_t* words, int first, int last)
+    {
+        const int word = (unsigned int)first / WORD_BITS, shift = (unsigned int)first % WORD_BITS, length = last - first + 1;
+        // The 64 bits from 'first' on, out of the word holding it and the next one
+        const auto bits_from = [&](int index) { return (words[index] >> shift) | ((words[index + 1] << 1) << (WORD_BITS - 1 - shift)); };
+        if (length <= WORD_BITS)
+            return std::popcount(bits_from(word) & (~0ull >> (WORD_BITS - length)));
+
+        // Only for radii above 31
+        unsigned int count = 0;
+        int index = word;
+        for (int remaining = length; remaining > 0; remaining -= WORD_BITS, ++index)
+            count += std::popcount(bits_from(index) & (~0ull >> (WORD_BITS - std::min(remaining, WORD_BITS))));
+        return count;
+    }
+
+    [[gnu::always_inline]] inline void count_row_body(const RowCount& row)
+    {
+        // Copied, as the totals written could alias them
+        const uint64_t* const open = row.open;
+        const uint64_t* const blocked = row.blocked;
+        const uint64_t* const countable = row.countable;
+        const int nr_words = row.nr_words, word_offset = row.word_offset, radius = row.radius;
+        const int last_column = row.nr_columns - 1 - word_offset;
+        unsigned int* const totals = row.totals;
+        const int total_offset = word_offset - row.first_total;
+
+        // Open routers of the same run of unblocked columns share its ends; columns are relative to the sweep here
+        int run_start = 0, run_end = -1;
+        for (int word = 0; word < nr_words; ++word)
+            for (uint64_t routers = open[word]; routers; routers &= routers - 1)
+            {
+                const int c = word * WORD_BITS + std::countr_zero(routers);
+                if (c > run_end)
+                {
+                    run_start = previous_set_bit(blocked, c) + 1;
+                    run_end = std::min(next_set_bit(blocked, nr_words, c) - 1, last_column);
+                }
+
+                const int right_end = std::min(run_end, c + radius);
+                const int left_start = std::max(run_start, c - radius);
+                totals[c + total_offset] += count_bits(countable, left_start, right_end);
+            }
+    }
+
+    // blocked |= walls, open = candidates & ~blocked; returns whether any candidate is still open
+    inline bool fold_row_scalar(uint64_t* blocked, const uint64_t* walls, const uint64_t* candidates, uint64_t* open, size_t nr_words)
+    {
+        uint64_t any_open = 0;
+        for (size_t word = 0; word < nr_words; ++word)
+        {
+            blocked[word] |= walls[word];
+            open[word] = candidates[word] & ~blocked[word];
+            any_open |= open[word];
+        }
+        return any_open != 0;
+    }
+
+    // Adds the number of countable targets every open router covers in the row
+    inline void count_row_scalar(const RowCount& row)
+    {
+        count_row_body(row);
+    }
+
+#ifdef COVERAGE_COUNTER_HAS_AVX2
+    __attribute__((target("avx2")))
+    inline bool fold_row_avx2(uint64_t* blocked, const uint64_t* walls, const uint64_t* candidates, uint64_t* open, size_t nr_words)
+    {
+        __m256i any_open = _mm256_setzero_si256();
+        size_t word = 0;
+        for (; word + 4 <= nr_words; word += 4)
+        {
+            const __m256i blocked_words = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(blocked + word)),
+                                                          _mm256_loadu_si256((const __m256i*)(walls + word)));
+            const __m256i open_words = _mm256_andnot_si256(blocked_words, _mm256_loadu_si256((const __m256i*)(candidates + word)));
+            _mm256_storeu_si256((__m256i*)(blocked + word), blocked_words);
+            _mm256_storeu_si256((__m256i*)(open + word), open_words);
+            any_open = _mm256_or_si256(any_open, open_words);
+        }
+        const bool tail_open = fold_row_scalar(blocked + word, walls + word, candidates + word, open + word, nr_words - word);
+        return tail_open || !_mm256_testz_si256(any_open, any_open);
+    }
+
+    __attribute__((target("avx2,popcnt,bmi,bmi2")))
+    inline void count_row_avx2(const RowCount& row)
+    {
+        count_row_body(row);
+    }
+#endif
+
+    using FoldRow = bool (*)(uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, size_t);
+    using CountRow = void (*)(const RowCount&);
+
+    inline CoverageIsa best_isa()
+    {
+#ifdef COVERAGE_COUNTER_HAS_AVX2
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2"))
+            return CoverageIsa::Avx2;
+#endif
+        return CoverageIsa::Scalar;
+    }
+
+    inline FoldRow fold_row_for(CoverageIsa isa)
+    {
+#ifdef COVERAGE_COUNTER_HAS_AVX2
+        if (isa == CoverageIsa::Avx2)
+            return fold_row_avx2;
+#endif
+        return fold_row_scalar;
+    }
+
+    inline CountRow count_row_for(CoverageIsa isa)
+    {
+#ifdef COVERAGE_COUNTER_HAS_AVX2
+        if (isa == CoverageIsa::Avx2)
+            return count_row_avx2;
+#endif
+        return count_row_scalar;
+    }
+}
+
+class CoverageCounter
+{
+private:
+    static constexpr int WORD_BITS = coverage_simd::WORD_BITS;
+
+    const BitGrid& walls;
+    int radius;
+    // The targets which are counted, with a spare word of zeros at the end of every row for count_bits
+    BitGrid countable;
+    coverage_simd::FoldRow fold_row;
+    coverage_simd::CountRow count_row;
+
+public:
+
+    // The cells counted are the ones set in 'targets' and not set in 'excluded' (e.g. already covered ones)
+    CoverageCounter(const BitGrid& walls, const BitGrid& targets, int router_radius, const BitGrid* excluded = nullptr)
+    : walls(walls)
+    , radius(router_radius)
+    , countable(targets.rows(), targets.columns() + WORD_BITS)
+    {
+        force_isa(coverage_simd::best_isa());
+        for (size_t x = 0; x < countable.rows(); ++x)
+        {
+            uint64_t* row = countable.row(x);
+            const uint64_t* target_row = targets.row(x);
+            for (size_t word = 0; word < targets.words_per_row(); ++word)
+                row[word] = target_row[word] & (excluded ? ~excluded->row(x)[word] : ~0ull);
+        }
+    }
+
+    // Overrides the instruction set picked from the CPU, e.g. to compare both paths; one the CPU lacks falls back
+    // to the scalar path
+    void force_isa(CoverageIsa isa)
+    {
+        if (isa == CoverageIsa::Avx2 && coverage_simd::best_isa() != CoverageIsa::Avx2)
+            isa = CoverageIsa::Scalar;
+        fold_row = coverage_simd::fold_row_for(isa);
+        count_row = coverage_simd::count_row_for(isa);
+    }
+
+    // Writes, for every (i, j) of the window [(i1, j1), (i2, j2)], the number of countable targets a router
+    // placed there covers, or 0 where is_candidate(i, j) does not hold. Windows can be processed concurrently.
+    template <typename IsCandidate>
+    void count_window(Grid<unsigned int>& coverage, int i1, int j1, int i2, int j2, IsCandidate&& is_candidate) const
+    {
+        const int nr_rows = walls.rows(), nr_columns = walls.columns();
+
+        // Only the words holding columns within R of the window can block or be covered
+        const int first_word = std::max(0, j1 - radius) / WORD_BITS;
+        const int last_word = std::min(nr_columns - 1, j2 + radius) / WORD_BITS;
+        const int nr_words = last_word - first_word + 1;
+        const int word_offset = first_word * WORD_BITS;
+
+        std::vector<uint64_t> candidates(nr_words), blocked(nr_words), open(nr_words);
+        std::vector<unsigned int> totals(j2 - j1 + 1);
+
+        for (int i = i1; i <= i2; ++i)
+        {
+            std::fill(candidates.begin(), candidates.end(), 0);
+            bool any_candidate = false;
+            for (int j = j1; j <= j2; ++j)
+                if (is_candidate(i, j))
+                {
+                    candidates[(j - word_offset) / WORD_BITS] |= 1ull << ((j - word_offset) % WORD_BITS);
+                    any_candidate = true;
+                }
+
+            std::fill(totals.begin(), totals.end(), 0);
+            if (any_candidate)
+            {
+                // The lower half (router row included), then the upper half
+                for (const int direction : { 1, -1 })
+                {
+                    std::fill(blocked.begin(), blocked.end(), 0);
+                    if (direction == -1)
+                        fold_row(blocked.data(), walls.row(i) + first_word, candidates.data(), open.data(), nr_words);
+
+                    for (int step = (direction == 1) ? 0 : 1; step <= radius; ++step)
+                    {
+                        const int x = i + direction * step;
+                        if (x < 0 || x >= nr_rows)
+                            break;
+
+                        // blocked: is there a wall in the column between rows i and x
+                        // Blocked columns stay blocked further out, so once no candidate is open this half is done
+                        if (!fold_row(blocked.data(), walls.row(x) + first_word, candidates.data(), open.data(), nr_words))
+                            break;
+
+                        count_row({ open.data(), blocked.data(), countable.row(x) + first_word, nr_words, word_offset,
+                                    radius, nr_columns, totals.data(), j1 });
+                    }
+                }
+            }
+
+            std::copy(totals.begin(), totals.end(), coverage[i] + j1);
+        }
+    }
+};
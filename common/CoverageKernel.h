@@ -0,0 +1,211 @@
+#pragma once
+/*
+ * Exact coverage of a single router.
+ * A cell is covered when there is no wall in the smallest rectangle containing it and the router. Going outward
+ * from the router, a cell is blocked iff it is a wall, or the cell before it on the row or the column is blocked,
+ * so each quadrant is swept row by row: OR the wall bits with the previous blocked row, then propagate the
+ * blocked state outward along the row. Every row of the (2R + 1)^2 window is handled as machine words, once.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "BitGrid.h"
+
+// Bit mask of the cells covered by one router; bit k of row dx is the cell (i - R + dx, j - R + k)
+class CoverageMask
+{
+private:
+    friend class CoverageKernel;
+
+    int radius = 0, words_per_row = 0;
+    int center_i = 0, center_j = 0;
+    std::vector<uint64_t> bits;
+
+    void resize(int router_radius)
+    {
+        if (router_radius == radius && !bits.empty())
+            return;
+        radius = router_radius;
+        words_per_row = (2 * radius + 1 + 63) / 64;
+        bits.assign((size_t)(2 * radius + 1) * words_per_row, 0);
+    }
+
+public:
+
+    [[nodiscard]] int router_radius() const
+    {
+        return radius;
+    }
+
+    [[nodiscard]] int window_words() const
+    {
+        return words_per_row;
+    }
+
+    // Row dx of the window, i.e. map row i - R + dx
+    [[nodiscard]] const uint64_t* row(int dx) const
+    {
+        return bits.data() + (size_t)dx * words_per_row;
+    }
+
+    [[nodiscard]] bool test(int i, int j) const
+    {
+        const int dx = i - center_i + radius, dy = j - center_j + radius;
+        if (dx < 0 || dy < 0 || dx > 2 * radius || dy > 2 * radius)
+            return false;
+        return (row(dx)[dy / 64] >> (dy % 64)) & 1;
+    }
+
+    [[nodiscard]] unsigned int count() const
+    {
+        unsigned int result = 0;
+        for (const uint64_t word : bits)
+            result += std::popcount(word);
+        return result;
+    }
+
+    // Calls f(i, j) for every covered cell, in row-major order
+    template <typename Function>
+    void for_each_cell(Function&& f) const
+    {
+        for (int dx = 0; dx <= 2 * radius; ++dx)
+            for (int word = 0; word < words_per_row; ++word)
+                for (uint64_t cells = row(dx)[word]; cells; cells &= cells - 1)
+                    f(center_i - radius + dx, center_j - radius + word * 64 + std::countr_zero(cells));
+    }
+};
+
+class CoverageKernel
+{
+private:
+    const BitGrid& walls;
+    const BitGrid& targets;
+    int radius;
+
+    // Extends every blocked cell of 'row' away from the center bit, on both sides of it
+    static void propagate_outward(uint64_t* row, int nr_words, int center)
+    {
+        const int center_word = center / 64, center_bit = center % 64;
+        const uint64_t right_part = ~0ull << center_bit;
+        const uint64_t left_part = (center_bit == 63) ? ~0ull : ((1ull << (center_bit + 1)) - 1);
+
+        uint64_t right = row[center_word] & right_part;
+        uint64_t left = row[center_word] & left_part;
+        right |= right << 1; right |= right << 2; right |= right << 4; right |= right << 8; right |= right << 16; right |= right << 32;
+        left |= left >> 1; left |= left >> 2; left |= left >> 4; left |= left >> 8; left |= left >> 16; left |= left >> 32;
+        row[center_word] = (right & right_part) | (left & left_part);
+
+        // Once a word has a blocked cell, everything further out is blocked as well
+        bool carry = (row[center_word] >> 63) & 1;
+        for (int word = center_word + 1; word < nr_words; ++word)
+        {
+            uint64_t x = carry ? ~0ull : row[word];
+            x |= x << 1; x |= x << 2; x |= x << 4; x |= x << 8; x |= x << 16; x |= x << 32;
+            row[word] = x;
+            carry = (x >> 63) & 1;
+        }
+
+        carry = row[center_word] & 1;
+        for (int word = center_word - 1; word >= 0; --word)
+        {
+            uint64_t x = carry ? ~0ull : row[word];
+            x |= x >> 1; x |= x >> 2; x |= x >> 4; x |= x >> 8; x |= x >> 16; x |= x >> 32;
+            row[word] = x;
+            carry = x & 1;
+        }
+    }
+
+    // Row x of the mask: the targets of row x which are not blocked
+    void store_covered(int x, long first_column, const uint64_t* blocked, uint64_t* covered, int nr_words,
+                       const BitGrid* excluded) const
+    {
+        for (int word = 0; word < nr_words; ++word)
+        {
+            uint64_t cells = targets.word_at(x, first_column + 64l * word) & ~blocked[word];
+            if (excluded)
+                cells &= ~excluded->word_at(x, first_column + 64l * word);
+            covered[word] = cells;
+        }
+
+        // Dropping the cells past the right edge of the window
+        const int window_width = 2 * radius + 1;
+        if (window_width % 64)
+            covered[nr_words - 1] &= (1ull << (window_width % 64)) - 1;
+    }
+
+    // Sweeps the rows above (direction = -1) or below (direction = 1) the router
+    void sweep(int i, int j, int direction, const uint64_t* center_blocked, uint64_t* blocked,
+               CoverageMask& mask, const BitGrid* excluded) const
+    {
+        const int nr_words = mask.words_per_row;
+        const long first_column = (long)j - radius;
+
+        std::copy(center_blocked, center_blocked + nr_words, blocked);
+        for (int step = 1; step <= radius; ++step)
+        {
+            const int x = i + direction * step;
+            if (x < 0 || x >= (int)walls.rows())
+                break;
+
+            for (int word = 0; word < nr_words; ++word)
+                blocked[word] |= walls.word_at(x, first_column + 64l * word);
+            propagate_outward(blocked, nr_words, radius);
+
+            store_covered(x, first_column, blocked, mask.bits.data() + (size_t)(radius + direction * step) * nr_words,
+                          nr_words, excluded);
+        }
+    }
+
+public:
+
+    CoverageKernel(const BitGrid& walls, const BitGrid& targets, int router_radius)
+    : walls(walls)
+    , targets(targets)
+    , radius(router_radius)
+    {
+    }
+
+    // Fills 'mask' with the targets covered by a router at (i, j), leaving out the cells set in 'excluded'
+    void compute(int i, int j, CoverageMask& mask, const BitGrid* excluded = nullptr) const
+    {
+        mask.resize(radius);
+        mask.center_i = i;
+        mask.center_j = j;
+        std::fill(mask.bits.begin(), mask.bits.end(), 0);
+
+        const int nr_words = mask.words_per_row;
+        const long first_column = (long)j - radius;
+
+        // Scratch rows live on the stack for the usual radii
+        uint64_t small_rows[2][4];
+        std::vector<uint64_t> large_rows;
+        uint64_t* center_blocked = small_rows[0];
+        uint64_t* blocked = small_rows[1];
+        if (nr_words > 4)
+        {
+            large_rows.resize(2 * nr_words);
+            center_blocked = large_rows.data();
+            blocked = large_rows.data() + nr_words;
+        }
+
+        // The router's own row is shared by the upper and the lower quadrants
+        for (int word = 0; word < nr_words; ++word)
+            center_blocked[word] = walls.word_at(i, first_column + 64l * word);
+        propagate_outward(center_blocked, nr_words, radius);
+
+        store_covered(i, first_column, center_blocked, mask.bits.data() + (size_t)radius * nr_words, nr_words, excluded);
+
+        sweep(i, j, 1, center_blocked, blocked, mask, excluded);
+        sweep(i, j, -1, center_blocked, blocked, mask, excluded);
+    }
+
+    [[nodiscard]] CoverageMask compute(int i, int j, const BitGrid* excluded = nullptr) const
+    {
+        CoverageMask mask;
+        compute(i, j, mask, excluded);
+        return mask;
+    }
+};
@@ -0,0 +1,94 @@
+#pragma once
+/*
+ * Contiguous 2D containers shared by all the solutions.
+ * Every row lives in one 64-byte aligned allocation, and the row stride is padded to a whole number
+ * of cache lines, so grid[i][j] is a single multiply-add away and rows can be scanned with vector loads.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+inline constexpr size_t GRID_ALIGNMENT = 64;
+
+template <typename T>
+class Grid
+{
+private:
+    struct AlignedDeleter
+    {
+        void operator()(T* cells) const
+        {
+            ::operator delete[](cells, std::align_val_t{GRID_ALIGNMENT});
+        }
+    };
+
+    size_t nr_rows = 0, nr_columns = 0, stride = 0;
+    std::unique_ptr<T[], AlignedDeleter> cells;
+
+    static size_t padded_stride(size_t columns)
+    {
+        if constexpr (GRID_ALIGNMENT % sizeof(T) == 0)
+        {
+            constexpr size_t cells_per_line = GRID_ALIGNMENT / sizeof(T);
+            return (columns + cells_per_line - 1) / cells_per_line * cells_per_line;
+        }
+        else
+            return columns;
+    }
+
+public:
+
+    Grid() = default;
+
+    Grid(size_t nr_rows, size_t nr_columns, const T& value = T{})
+    : nr_rows(nr_rows)
+    , nr_columns(nr_columns)
+    , stride(padded_stride(nr_columns))
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "Grid only holds plain cell values");
+
+        const size_t nr_cells = std::max<size_t>(nr_rows * stride, 1);
+        cells.reset(static_cast<T*>(::operator new[](nr_cells * sizeof(T), std::align_val_t{GRID_ALIGNMENT})));
+        std::uninitialized_fill(cells.get(), cells.get() + nr_cells, value);
+    }
+
+    T* operator[](size_t row)
+    {
+        return cells.get() + row * stride;
+    }
+
+    const T* operator[](size_t row) const
+    {
+        return cells.get() + row * stride;
+    }
+
+    [[nodiscard]] size_t rows() const
+    {
+        return nr_rows;
+    }
+
+    [[nodiscard]] size_t columns() const
+    {
+        return nr_columns;
+    }
+
+    // Distance in elements between the starts of two consecutive rows
+    [[nodiscard]] size_t row_stride() const
+    {
+        return stride;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return cells == nullptr;
+    }
+
+    void fill(const T& value)
+    {
+        std::fill(cells.get(), cells.get() + nr_rows * stride, value);
+    }
+};
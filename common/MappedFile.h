@@ -0,0 +1,107 @@
+#pragma once
+/*
+ * Read-only view of a whole file. On POSIX systems the file is memory mapped, so concurrent
+ * solver processes share the same page-cache pages; elsewhere it is read into an owned buffer.
+ */
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_USE_MMAP 1
+#endif
+
+class MappedFile
+{
+private:
+    const char* begin = nullptr;
+    size_t length = 0;
+    bool is_mapped = false;
+    std::vector<char> fallback_buffer;
+
+    void read_into_buffer(const std::string& filename)
+    {
+        std::ifstream fin(filename, std::ios::binary);
+        if (!fin)
+            throw std::runtime_error("Could not open " + filename);
+
+        fallback_buffer.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+        begin = fallback_buffer.data();
+        length = fallback_buffer.size();
+    }
+
+    void release()
+    {
+#ifdef MAPPED_FILE_USE_MMAP
+        if (is_mapped)
+            munmap(const_cast<char*>(begin), length);
+#endif
+        begin = nullptr;
+        length = 0;
+        is_mapped = false;
+        fallback_buffer.clear();
+    }
+
+public:
+
+    explicit MappedFile(const std::string& filename)
+    {
+#ifdef MAPPED_FILE_USE_MMAP
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Could not open " + filename);
+
+        struct stat file_stats{};
+        if (fstat(fd, &file_stats) == 0 && file_stats.st_size > 0)
+        {
+            void* address = mmap(nullptr, file_stats.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED)
+            {
+                begin = static_cast<const char*>(address);
+                length = file_stats.st_size;
+                is_mapped = true;
+                // The plan is scanned front to back exactly once when it is classified
+                madvise(address, length, MADV_WILLNEED);
+            }
+        }
+        close(fd);
+        if (is_mapped)
+            return;
+#endif
+        read_into_buffer(filename);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+    : begin(other.begin)
+    , length(other.length)
+    , is_mapped(other.is_mapped)
+    , fallback_buffer(std::move(other.fallback_buffer))
+    {
+        if (!is_mapped)
+            begin = fallback_buffer.data();
+        other.begin = nullptr;
+        other.length = 0;
+        other.is_mapped = false;
+    }
+
+    ~MappedFile()
+    {
+        release();
+    }
+
+    [[nodiscard]] std::string_view contents() const
+    {
+        return {begin, length};
+    }
+};
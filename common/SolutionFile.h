@@ -0,0 +1,155 @@
+#pragma once
+/*
+ * Reader for the solution (output) files: the number of backbone cells and one "row column" line per cell,
+ * then the same for the routers. The file is mapped and parsed in place; anything malformed or out of the
+ * map throws, with the line it was found on.
+ * SolutionStream walks the two sections cell by cell without storing them (finding where the routers start
+ * takes one pass over the backbone, which stores nothing either); SolutionFile loads both into vectors.
+ */
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.h"
+
+class SolutionStream
+{
+private:
+    struct Parser
+    {
+        std::string_view text;
+        size_t pos = 0;
+        int line = 1;
+
+        int next_int(const char* what)
+        {
+            while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\r' || text[pos] == '\t'))
+                line += text[pos++] == '\n';
+
+            int value = 0;
+            const auto [end, error] = std::from_chars(text.data() + pos, text.data() + text.size(), value);
+            if (error != std::errc())
+                fail(std::string("expected a ") + what);
+            pos = end - text.data();
+            return value;
+        }
+
+        [[noreturn]] void fail(const std::string& message) const
+        {
+            throw std::runtime_error("line " + std::to_string(line) + ": " + message);
+        }
+    };
+
+public:
+    // The cells of one section, in file order; copies walk the section independently
+    class Section
+    {
+    private:
+        friend class SolutionStream;
+
+        Parser parser;
+        int nr_cells = 0, nr_left = 0;
+        int nr_rows = 0, nr_columns = 0;
+
+        Section(Parser start, int nr_rows, int nr_columns)
+        : parser(start)
+        , nr_rows(nr_rows)
+        , nr_columns(nr_columns)
+        {
+            nr_cells = parser.next_int("cell count");
+            if (nr_cells < 0)
+                parser.fail("negative cell count");
+            nr_left = nr_cells;
+        }
+
+        // The text right after the section
+        [[nodiscard]] Parser end() const
+        {
+            Section rest = *this;
+            std::pair<int, int> cell;
+            while (rest.next(cell));
+            return rest.parser;
+        }
+
+    public:
+        [[nodiscard]] int size() const
+        {
+            return nr_cells;
+        }
+
+        // Reads the next cell into 'cell'; returns false once the section is over
+        bool next(std::pair<int, int>& cell)
+        {
+            if (nr_left == 0)
+                return false;
+            const int row = parser.next_int("row");
+            const int column = parser.next_int("column");
+            if (row < 0 || row >= nr_rows || column < 0 || column >= nr_columns)
+                parser.fail("cell (" + std::to_string(row) + ", " + std::to_string(column) + ") is outside the map");
+            cell = {row, column};
+            nr_left--;
+            return true;
+        }
+
+        // Whether the cells left come in non-decreasing row order, as the solvers write them (one pass, on a copy)
+        [[nodiscard]] bool is_row_ordered() const
+        {
+            Section rest = *this;
+            std::pair<int, int> cell;
+            for (int previous_row = 0; rest.next(cell); previous_row = cell.first)
+                if (cell.first < previous_row)
+                    return false;
+            return true;
+        }
+    };
+
+    // The cells must lie within a nr_rows x nr_columns map
+    SolutionStream(const std::string& filename, int nr_rows, int nr_columns)
+    : file(filename)
+    , backbone_section(Parser{file.contents()}, nr_rows, nr_columns)
+    , routers_section(backbone_section.end(), nr_rows, nr_columns)
+    {
+    }
+
+    SolutionStream(const SolutionStream&) = delete;
+    SolutionStream& operator=(const SolutionStream&) = delete;
+
+    // Valid as long as the stream is
+    [[nodiscard]] Section backbone() const
+    {
+        return backbone_section;
+    }
+
+    [[nodiscard]] Section routers() const
+    {
+        return routers_section;
+    }
+
+private:
+    // Declared first, so that it is mapped before the sections are found in it
+    MappedFile file;
+    Section backbone_section, routers_section;
+};
+
+struct SolutionFile
+{
+    std::vector<std::pair<int, int>> backbone;
+    std::vector<std::pair<int, int>> routers;
+
+    // The cells must lie within a nr_rows x nr_columns map
+    SolutionFile(const std::string& filename, int nr_rows, int nr_columns)
+    {
+        const SolutionStream stream(filename, nr_rows, nr_columns);
+        for (auto [cells, section] : { std::pair{ &backbone, stream.backbone() }, std::pair{ &routers, stream.routers() } })
+        {
+            cells->reserve(section.size());
+            std::pair<int, int> cell;
+            while (section.next(cell))
+                cells->push_back(cell);
+        }
+    }
+};
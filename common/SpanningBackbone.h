@@ -0,0 +1,159 @@
+#pragma once
+/*
+ * Backbone rebuilt as a spanning tree of the routers under Chebyshev distance, with shared cable merged.
+ * max(|di|, |dj|) is half the Manhattan distance between the rotated points (i + j, i - j), so the classic
+ * Manhattan MST sweep applies: in each of 4 orientations, one pass with an ordered map finds every point's
+ * closest neighbour in one octant, which gives at most 4n candidate edges for Kruskal, O(n log n) overall.
+ * The tree is then laid from the root outward, each router cabled to the closest cell of the backbone laid so
+ * far instead of to its tree parent: that cell is never farther, and cables end up sharing cells. This stands in
+ * for a Steiner step: cables join where they meet the backbone, but no Steiner point is placed off it.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "BackboneIndex.h"
+#include "BackboneMap.h"
+
+namespace spanning_backbone
+{
+    using Cell = std::pair<int, int>;
+
+    // Edges (a, b) of a minimum spanning tree of 'points' under Chebyshev distance
+    inline std::vector<std::pair<uint32_t, uint32_t>> chebyshev_spanning_tree(const std::vector<Cell>& points)
+    {
+        const uint32_t nr_points = points.size();
+
+        // Rotated by 45 degrees: Chebyshev distance becomes half the Manhattan distance
+        std::vector<Cell> rotated(nr_points);
+        for (uint32_t index = 0; index < nr_points; ++index)
+            rotated[index] = {points[index].first + points[index].second, points[index].first - points[index].second};
+
+        // Manhattan distance (in rotated coordinates), a, b
+        std::vector<std::tuple<int, uint32_t, uint32_t>> candidates;
+        candidates.reserve(4 * (size_t)nr_points);
+
+        std::vector<uint32_t> order(nr_points);
+        std::iota(order.begin(), order.end(), 0);
+        for (int orientation = 0; orientation < 4; ++orientation)
+        {
+            // Swept by increasing x + y: 'waiting' holds, keyed on -y, the points whose closest neighbour in the
+            // current octant is not known yet, and the first point to fall in a waiting point's octant is it
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+            {
+                return rotated[a].first - rotated[b].first < rotated[b].second - rotated[a].second;
+            });
+
+            std::map<int, uint32_t> waiting;
+            for (const uint32_t point : order)
+            {
+                for (auto it = waiting.lower_bound(-rotated[point].second); it != waiting.end(); it = waiting.erase(it))
+                {
+                    const uint32_t other = it->second;
+                    const int delta_x = rotated[point].first - rotated[other].first;
+                    const int delta_y = rotated[point].second - rotated[other].second;
+                    if (delta_y > delta_x)
+                        break;
+                    candidates.emplace_back(delta_x + delta_y, point, other);
+                }
+                waiting[-rotated[point].second] = point;
+            }
+
+            for (auto& [x, y] : rotated)
+                if (orientation % 2)
+                    x = -x;
+                else
+                    std::swap(x, y);
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+
+        // Kruskal, with a union-find over the points
+        std::vector<uint32_t> parent(nr_points);
+        std::iota(parent.begin(), parent.end(), 0);
+        const auto find = [&](uint32_t point)
+        {
+            while (parent[point] != point)
+                point = parent[point] = parent[parent[point]];
+            return point;
+        };
+
+        std::vector<std::pair<uint32_t, uint32_t>> tree;
+        tree.reserve(nr_points ? nr_points - 1 : 0);
+        for (const auto& [distance, a, b] : candidates)
+        {
+            const uint32_t root_a = find(a), root_b = find(b);
+            if (root_a == root_b)
+                continue;
+            parent[root_a] = root_b;
+            tree.emplace_back(a, b);
+        }
+        return tree;
+    }
+
+    // A backbone connecting all the 'terminals' to terminals[root] (e.g. the initial backbone cell)
+    inline BackboneMap build(const std::vector<Cell>& terminals, uint32_t root, int nr_rows, int nr_columns)
+    {
+        std::vector<std::vector<uint32_t>> neighbours(terminals.size());
+        for (const auto& [a, b] : chebyshev_spanning_tree(terminals))
+        {
+            neighbours[a].push_back(b);
+            neighbours[b].push_back(a);
+        }
+
+        BackboneMap backbone(nr_rows, nr_columns);
+        BackboneIndex index(nr_rows, nr_columns);
+        backbone.insert(terminals[root].first, terminals[root].second);
+        index.insert(terminals[root]);
+
+        // Breadth-first from the root, so a terminal's tree parent is always laid before it
+        std::vector<bool> reached(terminals.size(), false);
+        std::queue<uint32_t> pending;
+        pending.push(root);
+        reached[root] = true;
+        while (!pending.empty())
+        {
+            const uint32_t terminal = pending.front();
+            pending.pop();
+
+            if (terminal != root && !backbone.contains(terminals[terminal].first, terminals[terminal].second))
+            {
+                const auto [nearest, distance] = index.find_nearest(terminals[terminal]);
+                backbone.lay_cable(terminals[terminal].first, terminals[terminal].second, nearest.first, nearest.second);
+                index.insert_cable(terminals[terminal], nearest);
+            }
+
+            for (const uint32_t next : neighbours[terminal])
+                if (!reached[next])
+                {
+                    reached[next] = true;
+                    pending.push(next);
+                }
+        }
+        return backbone;
+    }
+
+    // Rebuilds 'backbone', which must hold the initial cell, as the spanning tree of the initial cell and the
+    // routers of any solver's Data, and keeps it if it is shorter. Returns the budget freed.
+    template <typename Data, typename Routers>
+    int rebuild(const Data& data, BackboneMap& backbone, const Routers& routers)
+    {
+        std::vector<Cell> terminals{Cell(data.initial_cell)};
+        for (const auto& router : routers)
+            terminals.emplace_back(router);
+
+        BackboneMap rebuilt = build(terminals, 0, data.nr_rows, data.nr_columns);
+        if (rebuilt.size() >= backbone.size())
+            return 0;
+
+        const int freed = (int)(backbone.size() - rebuilt.size()) * (int)data.backbone_cost;
+        backbone = std::move(rebuilt);
+        return freed;
+    }
+}
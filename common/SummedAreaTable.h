@@ -0,0 +1,50 @@
+#pragma once
+/*
+ * Summed-area table over a predicate on the building plan.
+ * It is stored as an (N + 1) x (M + 1) grid whose first row and column are zero, so the sum over any
+ * rectangle is exactly four lookups, without clamping the upper-left corner at the map border.
+ */
+
+#include "Grid.h"
+
+class SummedAreaTable
+{
+private:
+    Grid<unsigned int> sums;
+
+public:
+
+    SummedAreaTable() = default;
+
+    // is_counted(i, j) tells whether cell (i, j) contributes to the sums
+    template <typename Predicate>
+    SummedAreaTable(size_t nr_rows, size_t nr_columns, Predicate&& is_counted)
+    : sums(nr_rows + 1, nr_columns + 1, 0)
+    {
+        for (size_t i = 0; i < nr_rows; ++i)
+        {
+            const unsigned int* above = sums[i];
+            unsigned int* current = sums[i + 1];
+
+            unsigned int line_sum = 0;
+            for (size_t j = 0; j < nr_columns; ++j)
+            {
+                line_sum += is_counted(i, j) ? 1 : 0;
+                current[j + 1] = above[j + 1] + line_sum;
+            }
+        }
+    }
+
+    // prefix_row(i)[j] is the sum over the rectangle [(0, 0), (i - 1, j - 1)]; hot loops that keep the
+    // top and bottom rows of their rectangles fixed can hoist these pointers out of the inner loop
+    [[nodiscard]] const unsigned int* prefix_row(size_t i) const
+    {
+        return sums[i];
+    }
+
+    // Sum over the rectangle [(i1, j1), (i2, j2)], both corners inclusive
+    [[nodiscard]] unsigned int rect_sum(size_t i1, size_t j1, size_t i2, size_t j2) const
+    {
+        return sums[i2 + 1][j2 + 1] - sums[i1][j2 + 1] - sums[i2 + 1][j1] + sums[i1][j1];
+    }
+};
@@ -0,0 +1,389 @@
+#pragma once
+/*
+ * Persistent work-stealing thread pool, shared by the whole process through ThreadPool::global().
+ * Every worker owns a deque: it pushes and pops its own tasks at the back (newest first, still warm in cache),
+ * while idle workers steal from the front of the others' deques (oldest first, usually the biggest pieces of a
+ * recursive split). Threads outside the pool share one extra deque. A thread waiting on a TaskGroup runs queued
+ * tasks instead of blocking, so groups nest freely (fork/join) and a pool of n threads uses the caller as its
+ * n-th thread. parallel_for / parallel_for_chunks split a range recursively on top of that, and
+ * parallel_for_dynamic hands out the indices of a range one by one.
+ * The deques are not lock-free: each one is a std::deque behind its own mutex, and tasks are std::functions, so
+ * forking a task whose captures don't fit in std::function's small buffer allocates. This is meant for tasks of a
+ * few microseconds or more (bands, tiles, chunks of cells), where neither shows. A waiting thread which finds
+ * nothing to run yields and looks again rather than sleeping, since the tasks it waits for are running already.
+ * An exception thrown by a task is caught on the thread that ran it; the group's tasks not started yet are skipped,
+ * and wait() rethrows the first one once all the others are done.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class ThreadPool;
+
+// Tasks forked together and joined by wait(); the group must outlive its tasks, so wait() before destroying it
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool& pool)
+    : pool(pool)
+    {
+    }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    // Joins the tasks left, e.g. when an exception left the scope before wait(); their exception is dropped
+    ~TaskGroup()
+    {
+        join();
+    }
+
+    // Forks 'body': it runs on any thread of the pool, or on the one waiting for the group
+    template <typename Function>
+    void run(Function&& body);
+
+    // Joins every task forked so far, running queued tasks meanwhile, then rethrows the first exception of a task
+    void wait();
+
+private:
+    friend class ThreadPool;
+
+    ThreadPool& pool;
+    std::atomic<size_t> nr_pending{0};
+
+    // The first exception thrown by a task, set once
+    std::atomic<bool> failed{false};
+    std::mutex exception_mutex;
+    std::exception_ptr exception;
+
+    void join();
+
+    void record_exception(std::exception_ptr thrown)
+    {
+        std::lock_guard lock(exception_mutex);
+        if (!exception)
+            exception = std::move(thrown);
+        failed.store(true, std::memory_order_relaxed);
+    }
+};
+
+class ThreadPool
+{
+public:
+    // Task counts since the last reset_metrics(), summed over all the threads
+    struct Metrics
+    {
+        uint64_t nr_tasks_spawned = 0;
+        uint64_t nr_tasks_executed = 0;
+        // Tasks executed by another thread than the one which forked them
+        uint64_t nr_tasks_stolen = 0;
+        // Passes over the other deques which found nothing to steal
+        uint64_t nr_failed_steals = 0;
+
+        [[nodiscard]] double steal_rate() const
+        {
+            return nr_tasks_executed ? (double)nr_tasks_stolen / nr_tasks_executed : 0.0;
+        }
+    };
+
+    // A pool of nr_threads threads, counting the one waiting for the work: nr_threads - 1 workers are started
+    explicit ThreadPool(size_t nr_threads = default_nr_threads())
+    : slots(std::max<size_t>(nr_threads, 1))
+    {
+        // Slot 0 is shared by the threads outside the pool, slots 1.. belong to the workers
+        for (size_t slot = 1; slot < slots.size(); ++slot)
+            workers.emplace_back([this, slot] { work(slot); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(sleep_mutex);
+            stopping = true;
+        }
+        wake_up.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    // The process-wide pool, sized to the hardware
+    static ThreadPool& global()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // The hardware threads, unless THREAD_POOL_SIZE says otherwise (e.g. to time a solver at several thread counts)
+    static size_t default_nr_threads()
+    {
+        if (const char* pool_size = std::getenv("THREAD_POOL_SIZE"))
+            if (const long nr_threads = std::strtol(pool_size, nullptr, 10); nr_threads > 0)
+                return nr_threads;
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    [[nodiscard]] size_t nr_threads() const
+    {
+        return slots.size();
+    }
+
+    // Calls body(chunk_begin, chunk_end) over disjoint chunks of at most 'grain' indices covering [begin, end),
+    // in parallel; a range which fits in one chunk runs right away on the calling thread
+    template <typename Function>
+    void parallel_for_chunks(size_t begin, size_t end, size_t grain, Function&& body)
+    {
+        grain = std::max<size_t>(grain, 1);
+        if (end <= begin)
+            return;
+        if (end - begin <= grain)
+        {
+            body(begin, end);
+            return;
+        }
+
+        TaskGroup group(*this);
+        // The chunk run here fails like the forked ones: the rest of the group is skipped, and wait() rethrows
+        try
+        {
+            split(group, begin, end, grain, body);
+        }
+        catch (...)
+        {
+            group.record_exception(std::current_exception());
+        }
+        group.wait();
+    }
+
+    // Calls body(index) for every index in [begin, end), in parallel, 'grain' consecutive indices per task
+    template <typename Function>
+    void parallel_for(size_t begin, size_t end, size_t grain, Function&& body)
+    {
+        parallel_for_chunks(begin, end, grain, [&](size_t chunk_begin, size_t chunk_end)
+        {
+            for (size_t index = chunk_begin; index < chunk_end; ++index)
+                body(index);
+        });
+    }
+
+    // Calls body(index) for every index in [begin, end), handing the indices out one at a time and in order to
+    // one task per thread: for uneven items, sorted heaviest first, this balances better than a fixed split
+    template <typename Function>
+    void parallel_for_dynamic(size_t begin, size_t end, Function&& body)
+    {
+        std::atomic<size_t> next_index{begin};
+        const size_t nr_tasks = std::min(nr_threads(), end > begin ? end - begin : 0);
+        parallel_for(0, nr_tasks, 1, [&](size_t)
+        {
+            for (size_t index = next_index++; index < end; index = next_index++)
+                body(index);
+        });
+    }
+
+    [[nodiscard]] Metrics metrics() const
+    {
+        Metrics total;
+        for (const auto& slot : slots)
+        {
+            total.nr_tasks_spawned += slot.nr_tasks_spawned.load(std::memory_order_relaxed);
+            total.nr_tasks_executed += slot.nr_tasks_executed.load(std::memory_order_relaxed);
+            total.nr_tasks_stolen += slot.nr_tasks_stolen.load(std::memory_order_relaxed);
+            total.nr_failed_steals += slot.nr_failed_steals.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void reset_metrics()
+    {
+        for (auto& slot : slots)
+        {
+            slot.nr_tasks_spawned.store(0, std::memory_order_relaxed);
+            slot.nr_tasks_executed.store(0, std::memory_order_relaxed);
+            slot.nr_tasks_stolen.store(0, std::memory_order_relaxed);
+            slot.nr_failed_steals.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    friend class TaskGroup;
+
+    struct Task
+    {
+        std::function<void()> body;
+        TaskGroup* group;
+    };
+
+    // One deque and the counters of one thread, on their own cache lines
+    struct alignas(64) Slot
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::atomic<uint64_t> nr_tasks_spawned{0}, nr_tasks_executed{0}, nr_tasks_stolen{0}, nr_failed_steals{0};
+    };
+
+    std::vector<Slot> slots;
+    std::vector<std::thread> workers;
+
+    // Workers sleep while nothing is queued anywhere
+    std::atomic<size_t> nr_queued{0};
+    std::mutex sleep_mutex;
+    std::condition_variable wake_up;
+    bool stopping = false;
+
+    // The slot of the calling thread in this pool: its own for a worker, the shared one (0) for anyone else
+    [[nodiscard]] size_t current_slot() const
+    {
+        return (current_pool == this) ? current_slot_index : 0;
+    }
+
+    inline static thread_local const ThreadPool* current_pool = nullptr;
+    inline static thread_local size_t current_slot_index = 0;
+
+    void push(Task task)
+    {
+        const size_t slot = current_slot();
+        task.group->nr_pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard lock(slots[slot].mutex);
+            slots[slot].tasks.push_back(std::move(task));
+        }
+        slots[slot].nr_tasks_spawned.fetch_add(1, std::memory_order_relaxed);
+        nr_queued.fetch_add(1, std::memory_order_release);
+
+        if (!workers.empty())
+        {
+            // Taking the lock orders this against a worker checking nr_queued right before it sleeps
+            { std::lock_guard lock(sleep_mutex); }
+            wake_up.notify_one();
+        }
+    }
+
+    // The newest task of our own deque, or else the oldest task of another one
+    std::optional<Task> find_task(size_t slot)
+    {
+        if (nr_queued.load(std::memory_order_acquire) == 0)
+            return std::nullopt;
+
+        if (auto task = take(slot, false))
+            return task;
+        for (size_t offset = 1; offset < slots.size(); ++offset)
+            if (auto task = take((slot + offset) % slots.size(), true))
+            {
+                slots[slot].nr_tasks_stolen.fetch_add(1, std::memory_order_relaxed);
+                return task;
+            }
+
+        slots[slot].nr_failed_steals.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    std::optional<Task> take(size_t slot, bool from_front)
+    {
+        std::lock_guard lock(slots[slot].mutex);
+        auto& tasks = slots[slot].tasks;
+        if (tasks.empty())
+            return std::nullopt;
+
+        Task task = std::move(from_front ? tasks.front() : tasks.back());
+        if (from_front)
+            tasks.pop_front();
+        else
+            tasks.pop_back();
+        nr_queued.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    // Runs a task, unless its group already failed; the group may be gone once nr_pending is decremented
+    void execute(Task& task, size_t slot)
+    {
+        TaskGroup& group = *task.group;
+        if (!group.failed.load(std::memory_order_relaxed))
+        {
+            try
+            {
+                task.body();
+            }
+            catch (...)
+            {
+                group.record_exception(std::current_exception());
+            }
+        }
+        slots[slot].nr_tasks_executed.fetch_add(1, std::memory_order_relaxed);
+        group.nr_pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void work(size_t slot)
+    {
+        current_pool = this;
+        current_slot_index = slot;
+        while (true)
+        {
+            if (auto task = find_task(slot))
+            {
+                execute(*task, slot);
+                continue;
+            }
+
+            std::unique_lock lock(sleep_mutex);
+            wake_up.wait(lock, [&] { return stopping || nr_queued.load(std::memory_order_acquire) > 0; });
+            if (stopping && nr_queued.load(std::memory_order_acquire) == 0)
+                return;
+        }
+    }
+
+    // Forks the upper halves of [begin, end) until the rest is a single chunk, which runs right here
+    template <typename Function>
+    void split(TaskGroup& group, size_t begin, size_t end, size_t grain, Function& body)
+    {
+        while (end - begin > grain)
+        {
+            const size_t middle = begin + (end - begin) / 2;
+            group.run([this, &group, middle, end, grain, &body] { split(group, middle, end, grain, body); });
+            end = middle;
+        }
+        body(begin, end);
+    }
+};
+
+template <typename Function>
+void TaskGroup::run(Function&& body)
+{
+    pool.push({std::function<void()>(std::forward<Function>(body)), this});
+}
+
+inline void TaskGroup::wait()
+{
+    join();
+    if (failed.load(std::memory_order_relaxed))
+    {
+        failed.store(false, std::memory_order_relaxed);
+        std::rethrow_exception(std::exchange(exception, nullptr));
+    }
+}
+
+inline void TaskGroup::join()
+{
+    const size_t slot = pool.current_slot();
+    while (nr_pending.load(std::memory_order_acquire) != 0)
+    {
+        if (auto task = pool.find_task(slot))
+            pool.execute(*task, slot);
+        else
+            std::this_thread::yield();
+    }
+}
@@ -2,4 +2,4 @@
 
 using Matrix = std::pair < std::pair<unsigned int, unsigned int>, std::pair<unsigned int, unsigned int>>;
 using query_result = std::pair<unsigned int, std::pair<unsigned int, unsigned int>>;
-using Point = pair<unsigned int, unsigned int>;
\ No newline at end of file
+using Point = std::pair<unsigned int, unsigned int>;
\ No newline at end of file
@@ -2,111 +2,204 @@
 #include <iostream>
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <optional>
+#include <queue>
 #include <vector>
 #include "Definitions.h"
+#include "../common/Grid.h"
 
+/*
+ * 2D segment tree (a segment tree over the rows, whose every node is a segment tree over the columns), answering
+ * the maximum of any rectangle in O(log N * log M), and zeroing a position in O(log N * log M).
+ * Each position is stored as one 64-bit key holding its value, then its row (reversed), then its column, so the
+ * maximum key is the biggest value, with ties going to the topmost row and then to the rightmost column.
+ * Both trees are the bottom-up kind, in a single (2N) x (2M) allocation.
+ */
 class SegTree2D
 {
 private:
-	std::unique_ptr < std::unique_ptr<query_result[]>[]> seg_tree;
+	static constexpr unsigned int COORD_BITS = 21;
+	static constexpr uint64_t COORD_MASK = (1ull << COORD_BITS) - 1;
+
+	Grid<uint64_t> seg_tree;
 	size_t n, m;
 
-	inline void build_tree(size_t tree_index, const std::unique_ptr<std::unique_ptr<unsigned int[]>[]>& mat, size_t node, size_t left, size_t right)
+	static uint64_t make_key(unsigned int value, size_t row, size_t column)
 	{
-		if (left == right)
-			seg_tree[tree_index][node] = std::make_pair(mat[tree_index][left - 1], std::make_pair(tree_index, left - 1));
-		else
-		{
-			size_t mid = (left + right) / 2;
-			build_tree(tree_index, mat, 2 * node, left, mid);
-			build_tree(tree_index, mat, 2 * node + 1, mid + 1, right);
-			
-			const query_result left_res = seg_tree[tree_index][2 * node];
-			const query_result right_res = seg_tree[tree_index][2 * node + 1];
-
-			seg_tree[tree_index][node] = ((left_res.first > right_res.first) ? left_res : right_res);
-		}
+		return ((uint64_t)value << (2 * COORD_BITS)) | ((COORD_MASK - row) << COORD_BITS) | column;
 	}
 
-	inline query_result get_max_subtree(size_t tree_index, size_t node, size_t left, size_t right, size_t x, size_t y) const
+	static query_result from_key(uint64_t key)
 	{
-		if (x <= left && right <= y)
-			return seg_tree[tree_index][node];
-		
-		size_t mid = (left + right) / 2;
-
-		std::optional<query_result> left_res, right_res;
-		if (x <= mid)
-			left_res = get_max_subtree(tree_index, 2 * node, left, mid, x, y);
-		if (y > mid)
-			right_res = get_max_subtree(tree_index, 2 * node + 1, mid + 1, right, x, y);
-
-		if (!left_res.has_value())
-		{
-			assert(right_res.has_value());
-			return right_res.value();
-		}
-		else if (!right_res.has_value())
+		return std::make_pair((unsigned int)(key >> (2 * COORD_BITS)),
+			std::make_pair((unsigned int)(COORD_MASK - ((key >> COORD_BITS) & COORD_MASK)), (unsigned int)(key & COORD_MASK)));
+	}
+
+	// Maximum key of the columns [j1, j2] in the column tree of a row node
+	uint64_t get_max_columns(size_t node, size_t j1, size_t j2) const
+	{
+		const uint64_t* column_tree = seg_tree[node];
+		uint64_t max_key = 0;
+		for (size_t left = j1 + m, right = j2 + m + 1; left < right; left /= 2, right /= 2)
 		{
-			assert(left_res.has_value());
-			return left_res.value();
+			if (left & 1)
+				max_key = std::max(max_key, column_tree[left++]);
+			if (right & 1)
+				max_key = std::max(max_key, column_tree[--right]);
 		}
-		else
-			return ((left_res.value().first > right_res.value().first) ? left_res.value() : right_res.value());
+		return max_key;
 	}
 
-	inline void update_subtree(size_t tree_index, size_t node, size_t left, size_t right, size_t x)
+	// Maximum key of the window [(i1, j1), (i2, j2)], 0 if nothing
+	uint64_t get_max_key(size_t i1, size_t j1, size_t i2, size_t j2) const
 	{
-		if (left == right)
-			seg_tree[tree_index][node].first = 0;
-		else
+		uint64_t max_key = 0;
+		for (size_t top = i1 + n, bottom = i2 + n + 1; top < bottom; top /= 2, bottom /= 2)
 		{
-			size_t mid = (left + right) / 2;
-			if (x <= mid)
-				update_subtree(tree_index, 2 * node, left, mid, x);
-			else
-				update_subtree(tree_index, 2 * node + 1, mid + 1, right, x);
-
-			const query_result left_res = seg_tree[tree_index][2 * node];
-			const query_result right_res = seg_tree[tree_index][2 * node + 1];
-			seg_tree[tree_index][node] = ((left_res.first > right_res.first) ? left_res : right_res);
+			if (top & 1)
+				max_key = std::max(max_key, get_max_columns(top++, j1, j2));
+			if (bottom & 1)
+				max_key = std::max(max_key, get_max_columns(--bottom, j1, j2));
 		}
+		return max_key;
 	}
 
 public:
-	SegTree2D(const std::unique_ptr<std::unique_ptr<unsigned int[]>[]>& mat, size_t _n, size_t _m): n{_n}, m{_m}
+	SegTree2D(const Grid<unsigned int>& mat, size_t _n, size_t _m): seg_tree(2 * _n, 2 * _m, 0), n{_n}, m{_m}
 	{
-		// Allocate memory for a segment tree for each line of the matrix
-		seg_tree = std::make_unique<std::unique_ptr<query_result[]>[]>(n);
-		for (size_t index = 0; index < n; ++index)
-			seg_tree[index] = std::make_unique<query_result[]>(4 * (m + 1));
-
-		// Build the segment trees
-		for (size_t index = 0; index < n; ++index)
-			build_tree(index, mat, 1, 1, m);
+		assert(n <= COORD_MASK && m <= COORD_MASK);
+
+		// The leaves of the row tree hold the rows themselves
+		for (size_t row = 0; row < n; ++row)
+		{
+			uint64_t* column_tree = seg_tree[n + row];
+			for (size_t column = 0; column < m; ++column)
+				column_tree[m + column] = make_key(mat[row][column], row, column);
+			for (size_t node = m - 1; node > 0; --node)
+				column_tree[node] = std::max(column_tree[2 * node], column_tree[2 * node + 1]);
+		}
+
+		// Every other row node holds, node by node, the maxima of its two children
+		for (size_t node = n - 1; node > 0; --node)
+		{
+			const uint64_t* upper = seg_tree[2 * node];
+			const uint64_t* lower = seg_tree[2 * node + 1];
+			uint64_t* column_tree = seg_tree[node];
+			for (size_t column_node = 1; column_node < 2 * m; ++column_node)
+				column_tree[column_node] = std::max(upper[column_node], lower[column_node]);
+		}
 	}
 
-	query_result get_max(Matrix mat_coords) const
+	// The best position of the window, or nothing if the window is empty
+	std::optional<query_result> get_max(Matrix mat_coords) const
 	{
-		assert(mat_coords.first.first < mat_coords.second.first);
-		assert(mat_coords.first.second < mat_coords.second.second);
-		assert(mat_coords.second.first <= n);
-		assert(mat_coords.second.second <= m);
+		assert(mat_coords.second.first < n);
+		assert(mat_coords.second.second < m);
 
-		std::vector<query_result> max_line_res;
-		for (size_t index = mat_coords.first.first; index <= mat_coords.second.first; ++index)
-			max_line_res.push_back(get_max_subtree(index, 1, 1, m, mat_coords.first.second + 1, mat_coords.second.second + 1));
+		// Every position has a non-zero key (its reversed row is), so 0 only comes out of an empty window
+		const uint64_t max_key = get_max_key(mat_coords.first.first, mat_coords.first.second, mat_coords.second.first, mat_coords.second.second);
+		if (max_key == 0)
+			return std::nullopt;
+		return from_key(max_key);
+	}
 
-		const query_result max_res = *std::max_element(max_line_res.begin(), max_line_res.end(), [](const query_result lhs, const query_result rhs) {
-			return lhs.first < rhs.first;
-			});
+	// The windows (at most 4) which make up 'outer' minus 'inner', the latter being nested in the former
+	static std::vector<Matrix> ring(const Matrix& outer, const Matrix& inner)
+	{
+		const auto [i1, j1] = outer.first;
+		const auto [i2, j2] = outer.second;
+		const auto [a1, b1] = inner.first;
+		const auto [a2, b2] = inner.second;
+		assert(i1 <= a1 && j1 <= b1 && a2 <= i2 && b2 <= j2);
 
-		return max_res;
+		// Full-width strips above and below the inner window, then the parts of its rows left and right of it
+		std::vector<Matrix> windows;
+		if (i1 < a1)
+			windows.push_back(std::make_pair(std::make_pair(i1, j1), std::make_pair(a1 - 1, j2)));
+		if (a2 < i2)
+			windows.push_back(std::make_pair(std::make_pair(a2 + 1, j1), std::make_pair(i2, j2)));
+		if (j1 < b1)
+			windows.push_back(std::make_pair(std::make_pair(a1, j1), std::make_pair(a2, b1 - 1)));
+		if (b2 < j2)
+			windows.push_back(std::make_pair(std::make_pair(a1, b2 + 1), std::make_pair(a2, j2)));
+		return windows;
 	}
 
+	// Lazily enumerates the positions of some disjoint windows with a non-zero value, by decreasing value (same
+	// tie-break as get_max), best first: the window holding the best position left is split around it, in at most
+	// 4 windows, and their maxima queued. k positions cost O(k * log N * log M), and nothing is stored in the tree
+	class Cursor
+	{
+	private:
+		const SegTree2D& st;
+		std::priority_queue<std::pair<uint64_t, Matrix>> windows;
+
+		void push(size_t i1, size_t j1, size_t i2, size_t j2)
+		{
+			const uint64_t max_key = st.get_max_key(i1, j1, i2, j2);
+			if (from_key(max_key).first > 0)
+				windows.emplace(max_key, std::make_pair(std::make_pair(i1, j1), std::make_pair(i2, j2)));
+		}
+
+	public:
+		explicit Cursor(const SegTree2D& st): st{st}
+		{
+		}
+
+		void add(const Matrix& window)
+		{
+			push(window.first.first, window.first.second, window.second.first, window.second.second);
+		}
+
+		// The best position left, without taking it out
+		std::optional<query_result> peek() const
+		{
+			if (windows.empty())
+				return std::nullopt;
+			return from_key(windows.top().first);
+		}
+
+		std::optional<query_result> next()
+		{
+			if (windows.empty())
+				return std::nullopt;
+
+			const auto [max_key, window] = windows.top();
+			windows.pop();
+			const query_result res = from_key(max_key);
+			const auto [row, column] = res.second;
+			const auto [i1, j1] = window.first;
+			const auto [i2, j2] = window.second;
+
+			if (i1 < row)
+				push(i1, j1, row - 1, j2);
+			if (row < i2)
+				push(row + 1, j1, i2, j2);
+			if (j1 < column)
+				push(row, j1, row, column - 1);
+			if (column < j2)
+				push(row, column + 1, row, j2);
+			return res;
+		}
+	};
+
 	void update(Point point)
 	{
-		update_subtree(point.first, 1, 1, m, point.second + 1);
+		size_t node = n + point.first;
+		size_t column_node = m + point.second;
+		uint64_t* column_tree = seg_tree[node];
+		column_tree[column_node] = make_key(0, point.first, point.second);
+		for (column_node /= 2; column_node > 0; column_node /= 2)
+			column_tree[column_node] = std::max(column_tree[2 * column_node], column_tree[2 * column_node + 1]);
+
+		for (node /= 2; node > 0; node /= 2)
+		{
+			const uint64_t* upper = seg_tree[2 * node];
+			const uint64_t* lower = seg_tree[2 * node + 1];
+			column_tree = seg_tree[node];
+			for (column_node = m + point.second; column_node > 0; column_node /= 2)
+				column_tree[column_node] = std::max(upper[column_node], lower[column_node]);
+		}
 	}
-};
\ No newline at end of file
+};
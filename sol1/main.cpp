@@ -1,22 +1,30 @@
 #include <iostream>
 #include <array>
 #include <cassert>
-#include <thread>
 #include <cstring>
 #include <cmath>
 #include <deque>
 #include <map>
+#include <atomic>
+#include <climits>
+#include <filesystem>
 #include "Data.h"
 #include "SegTree2D.h"
 #include "Definitions.h"
+#include "../common/Grid.h"
+#include "../common/BitGrid.h"
 #include "CoverageCalculator.h"
 #include "SolutionProcessor.h"
-#include <thread>
-#include <array>
-#include <mutex>
-#define NR_THREADS 18
+#include "../common/ThreadPool.h"
+#define NR_RADII 18
+#define MIN_ROUTERS_LOOKED_AROUND 10
+#define MAX_CANDIDATES_PER_RING 10
 
 using namespace std;
+// A router position, and the number of cells not covered yet that it would cover
+using window_candidate = pair<query_result, unsigned int>;
+// The best candidate of each of the nested windows around a router
+using candidates_around = array<optional<window_candidate>, NR_RADII>;
 unsigned long long final_score = 0;
 unsigned long long total_overlap = 0;
 
@@ -25,9 +33,15 @@ class Solver
 private:
 	const Data& data;
 	SegTree2D& st;
-	CoverageCalculator& coverage_calculator;
-	unique_ptr<unique_ptr<bool[]>[]> is_covered;
+	const CoverageCalculator& coverage_calculator;
+	BitGrid is_covered;
 	unsigned int nr_cells_covered = 0;
+	// actual_coverage[i][j] is the number of cells not covered yet that a router at (i, j) would cover, or UNKNOWN:
+	// it only changes within 2R of a new router, so it is kept across placement steps and forgotten just there
+	static constexpr unsigned int UNKNOWN = UINT_MAX;
+	mutable Grid<unsigned int> actual_coverage;
+	// The coverage mask of the router being placed (the tasks looking around routers each have their own)
+	CoverageMask placement_mask;
 
 	Matrix get_matrix(Point middle, unsigned int radius) const
 	{
@@ -40,14 +54,72 @@ private:
 		return make_pair(make_pair(upper_left_line, upper_left_col), make_pair(lower_right_line, lower_righ_col));
 	}
 
-	unsigned int get_actual_coverage(query_result qr) const
+	// Cells a router at qr's position would cover which are not covered yet
+	unsigned int get_actual_coverage(query_result qr, CoverageMask& scratch) const
+	{
+		// Tasks looking around different routers may count the same position at once, and store the same value
+		atomic_ref<unsigned int> cached(actual_coverage[qr.second.first][qr.second.second]);
+		unsigned int result = cached.load(memory_order_relaxed);
+		if (result == UNKNOWN)
+		{
+			result = coverage_calculator.count_covered_cells(qr.second, scratch, &is_covered);
+			cached.store(result, memory_order_relaxed);
+		}
+		return result;
+	}
+
+	// Forgets the coverage counts a router placed at 'router' may have changed
+	void forget_actual_coverage_around(Point router)
+	{
+		const unsigned int reach = 2 * data.router_radius;
+		for (unsigned int i = router.first - min(router.first, reach); i <= min(router.first + reach, data.nr_rows - 1); ++i)
+			fill(actual_coverage[i] + (router.second - min(router.second, reach)), actual_coverage[i] + min(router.second + reach, data.nr_columns - 1) + 1, UNKNOWN);
+	}
+
+	// For each of the nested windows around 'router' (radius 10, 13, ..., 61), the candidate which would cover the most
+	// cells not covered yet, among the best few of the window by coverage: the windows grow ring by ring, so each one
+	// only enumerates the positions of its ring, best first, and keeps the best of the smaller windows otherwise
+	candidates_around get_best_candidates_around(Point router) const
 	{
-		auto cells_covered_by_router = coverage_calculator.get_covered_cells(qr.second);
-		unsigned int overlap = 0;
-		for (auto cell : cells_covered_by_router)
-			if (is_covered[cell.first][cell.second])
-				++overlap;
-		return cells_covered_by_router.size() - overlap;
+		candidates_around best_candidates;
+		optional<window_candidate> best_candidate;
+		optional<Matrix> inner;
+		// Reused by every count of this call, which runs as one task
+		CoverageMask scratch;
+		for (size_t index = 0; index < NR_RADII; ++index)
+		{
+			const Matrix window = get_matrix(router, 10 + 3 * index);
+			SegTree2D::Cursor cursor(st);
+			if (!inner.has_value())
+				cursor.add(window);
+			else
+				for (const Matrix& strip : SegTree2D::ring(window, inner.value()))
+					cursor.add(strip);
+
+			bool improved = false;
+			for (unsigned int nr_candidates = 0; nr_candidates < MAX_CANDIDATES_PER_RING; ++nr_candidates)
+			{
+				// The coverage in the tree ignores the overlap, so a candidate can't cover more cells than that;
+				// routers already placed have a coverage of 0 there, and are never enumerated
+				const auto top = cursor.peek();
+				if (!top.has_value() || (best_candidate.has_value() && top.value().first <= best_candidate.value().second))
+					break;
+				cursor.next();
+
+				const unsigned int actual_coverage = get_actual_coverage(top.value(), scratch);
+				if (!best_candidate.has_value() || actual_coverage > best_candidate.value().second)
+				{
+					best_candidate = make_pair(top.value(), actual_coverage);
+					improved = true;
+				}
+			}
+
+			// A bigger window with the same candidate scores the same, and can never win the merge, so it is left empty
+			if (improved)
+				best_candidates[index] = best_candidate;
+			inner = window;
+		}
+		return best_candidates;
 	}
 
 	unsigned int get_distance(Point a, Point b) const
@@ -59,14 +131,10 @@ private:
 	}
 
 public:
-	Solver(const Data& data, SegTree2D& st, CoverageCalculator &coverage_calculator): data{data}, st{st}, coverage_calculator{coverage_calculator}
+	Solver(const Data& data, SegTree2D& st, const CoverageCalculator& coverage_calculator): data{data}, st{st}, coverage_calculator{coverage_calculator}
 	{
-		is_covered = make_unique<unique_ptr<bool[]>[]>(data.nr_rows);
-		for (size_t index = 0; index < data.nr_rows; ++index)
-		{
-			is_covered[index] = make_unique<bool[]>(data.nr_columns);
-			memset(is_covered[index].get(), 0, data.nr_columns);
-		}
+		is_covered = BitGrid(data.nr_rows, data.nr_columns);
+		actual_coverage = Grid<unsigned int>(data.nr_rows, data.nr_columns, UNKNOWN);
 	}
 
 	map<Point, Point> solve()
@@ -76,77 +144,86 @@ public:
 		map<Point, Point> routers_in_solution;
 		deque<Point> router_queue;
 		router_queue.push_front(data.initial_cell);
+
+		// The candidates around every router of the queue (same order), kept until a router is placed close enough
+		// to change them: the windows reach 60 cells away, and a router changes the coverage left within 2R of it
+		deque<optional<candidates_around>> cached_candidates;
+		cached_candidates.push_front(nullopt);
+		const unsigned int interaction_distance = (10 + 3 * (NR_RADII - 1) - 1) + 2 * data.router_radius;
 		while(true)
 		{
 			// Find the best position for a new router in the general area of the current router
-			optional<pair<query_result, double>> best_result;
+			optional<pair<query_result, unsigned int>> best_result;
 			Point best_result_maps_to;
 			assert(!best_result.has_value());
 			unsigned int best_result_cost = 0;
 			unsigned int best_result_overlap = 0;
 			
+			// Go over the routers already placed(and the initial cell of the backbone), a batch at a time on the thread pool:
+			// at least MIN_ROUTERS_LOOKED_AROUND of them, and then until some placement is found
 			int count = 0;
-			// Go over the routers already placed(and the initial cell of the backbone)
-			for (auto router : router_queue)
+			bool found = false;
+			for (size_t batch_start = 0; batch_start < router_queue.size() && !found; batch_start += MIN_ROUTERS_LOOKED_AROUND)
 			{
-				mutex modify_best_result_mtx;
-				auto get_best_result_for_given_radius = [&](unsigned int radius)
+				const size_t batch_end = min(router_queue.size(), batch_start + MIN_ROUTERS_LOOKED_AROUND);
+				vector<size_t> stale;
+				for (size_t index = batch_start; index < batch_end; ++index)
+					if (!cached_candidates[index].has_value())
+						stale.push_back(index);
+				ThreadPool::global().parallel_for(0, stale.size(), 1, [&](size_t stale_index)
 				{
-					Matrix matrix = get_matrix(router, radius);
-					query_result matrix_max = st.get_max(matrix);
+					cached_candidates[stale[stale_index]] = get_best_candidates_around(router_queue[stale[stale_index]]);
+				});
 
-					// if this router wasn't added before
-					if (routers_in_solution.find(matrix_max.second) == routers_in_solution.end())
+				// Merged in queue order, then in radius order, so the outcome never depends on scheduling
+				for (size_t index = batch_start; index < batch_end && !found; ++index)
+				{
+					const Point router = router_queue[index];
+					for (const auto& candidate : cached_candidates[index].value())
 					{
-						unsigned int actual_coverage = get_actual_coverage(matrix_max);
-						unsigned int overlap = matrix_max.first - actual_coverage;
+						if (!candidate.has_value())
+							continue;
 
+						const auto [matrix_max, actual_coverage] = candidate.value();
 						const unsigned int distance = get_distance(router, matrix_max.second);
 						const unsigned int placement_cost = distance * data.backbone_cost + data.router_cost;
 
-						double score = actual_coverage * 0.60 + ((200 - distance) / 2 * 0.40); // 69
-
-						modify_best_result_mtx.lock();
+						// actual_coverage * 0.60 + (200 - distance) / 2 * 0.40, times 10: in integers, so that ties don't depend
+						// on how the compiler rounds (e.g. fused multiply-adds)
+						const unsigned int score = 6 * actual_coverage + 4 * ((200 - distance) / 2);
 						if ((placement_cost <= remaining_budget) && (!best_result.has_value() || score > best_result.value().second))
 						{
 							best_result = make_pair(matrix_max, score);
 							best_result_cost = placement_cost;
 							best_result_maps_to = router;
-							best_result_overlap = overlap;
+							best_result_overlap = matrix_max.first - actual_coverage;
 						}
-						modify_best_result_mtx.unlock();
 					}
-				};
 
-				unsigned int radius = 10;
-				array<thread, NR_THREADS> compute_best_result_th;
-				for (size_t index = 0; index < NR_THREADS; ++index)
-				{
-					compute_best_result_th[index] = thread(get_best_result_for_given_radius, radius);
-					radius += 3;
+					count++;
+					if (count >= MIN_ROUTERS_LOOKED_AROUND && best_result.has_value())
+						found = true;
 				}
-
-				for (auto& th : compute_best_result_th)
-					th.join();
-					
-				count++;
-				if (count >= 10 && best_result.has_value())
-					break;
 			}
 			if (best_result.has_value())
 			{
-				routers_in_solution.insert(make_pair(best_result.value().first.second, best_result_maps_to));
-				router_queue.push_front(best_result.value().first.second);
+				const Point new_router = best_result.value().first.second;
+				for (size_t index = 0; index < router_queue.size(); ++index)
+					if (get_distance(router_queue[index], new_router) <= interaction_distance)
+						cached_candidates[index].reset();
+
+				routers_in_solution.insert(make_pair(new_router, best_result_maps_to));
+				router_queue.push_front(new_router);
+				cached_candidates.push_front(nullopt);
 				remaining_budget -= best_result_cost;
-				st.update(best_result.value().first.second);
+				st.update(new_router);
 
-				auto cells_covered_by_router = coverage_calculator.get_covered_cells(best_result.value().first.second);
-				for (auto cell : cells_covered_by_router)
-					if (!is_covered[cell.first][cell.second])
-					{
-						is_covered[cell.first][cell.second] = true;
-						++nr_cells_covered;
-					}
+				coverage_calculator.for_each_covered_cell(new_router, placement_mask, [&](unsigned int i, unsigned int j)
+				{
+					is_covered.set(i, j);
+					++nr_cells_covered;
+				}, &is_covered);
+				forget_actual_coverage_around(new_router);
 				solution_overlap += best_result_overlap;
 			}
 			else
@@ -161,17 +238,25 @@ public:
 	}
 };
 
-int main()
+int main(int argc, char** argv)
 {
 	const string in_prefix = "../../../input_files/";
 	const string out_prefix = "../../../output_files/sol1/";
 
 	const array<string, 4> input_files = { "charleston_road.in", "lets_go_higher.in", "opera.in", "rue_de_londres.in" };
 
-	for (string input_file : input_files)
+	// The four inputs above, or the single one given: sol1 <input file> <output file>
+	vector<pair<string, string>> jobs;
+	if (argc == 3)
+		jobs.emplace_back(argv[1], argv[2]);
+	else
+		for (const string& input_file : input_files)
+			jobs.emplace_back(in_prefix + input_file, out_prefix + input_file.substr(0, (input_file.find('.'))));
+
+	for (const auto& [input_path, output_path] : jobs)
 	{
-		cout << "Now working on " << input_file;
-		Data data(in_prefix + input_file);
+		cout << "Now working on " << filesystem::path(input_path).filename().string();
+		Data data(input_path);
 		cout << ". Input processed.\n";
 		
 		CoverageCalculator coverage_calculator(data);
@@ -180,13 +265,17 @@ int main()
 
 		SegTree2D st(coverage, data.nr_rows, data.nr_columns);
 		Solver solver(data, st, coverage_calculator);
-		coverage.reset();
+		coverage = Grid<unsigned int>();
 
 		auto raw_solution = solver.solve();
 		auto processed_solution = SolutionProcessor::process(data, raw_solution);
-		data.write_to_file(out_prefix + input_file.substr(0, (input_file.find('.'))), processed_solution);
+		data.write_to_file(output_path, processed_solution);
 	}
 	cout << "Final score = " << final_score << '\n';
 	cout << "Total cell overlaps = " << total_overlap << ", Potential score loss = " << (total_overlap * 1000) << '\n';
+
+	const auto pool_metrics = ThreadPool::global().metrics();
+	cout << "Thread pool: " << ThreadPool::global().nr_threads() << " threads, " << pool_metrics.nr_tasks_executed << " tasks, "
+		<< pool_metrics.steal_rate() * 100 << "% stolen\n";
 	return 0;
 }
\ No newline at end of file
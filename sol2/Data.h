@@ -2,8 +2,9 @@
 #include <iostream>
 #include <fstream>
 #include <set>
-#include "InParser.h"
 #include "Definitions.h"
+#include "../common/BuildingPlan.h"
+#include "../common/BackboneMap.h"
 
 using namespace std;
 
@@ -15,35 +16,26 @@ public:
 
 	unsigned int nr_rows, nr_columns, router_radius, backbone_cost, router_cost, budget;
 	pair<unsigned int, unsigned int> initial_cell;
-	unique_ptr<unique_ptr<char[]>[]> building_plan;
+	BuildingPlan building_plan;
 
 
-	Data(const string filename)
+	Data(const string filename): building_plan(filename)
 	{
-		ifstream fin(filename);
-//		InParser fin(filename);
-
-		fin >> nr_rows >> nr_columns >> router_radius >> backbone_cost >> router_cost >> budget;
-		fin >> initial_cell.first >> initial_cell.second;
-
-		// Allocating memory for the building plan
-		building_plan = make_unique<unique_ptr<char[]>[]>(nr_rows);
-		for (unsigned int index = 0; index < nr_rows; ++index)
-			building_plan[index] = make_unique<char[]>(nr_columns);
-
-		// Reading the building plan
-		for (unsigned int i = 0; i < nr_rows; ++i)
-			for (unsigned int j = 0; j < nr_columns; ++j)
-				fin >> building_plan[i][j];
+		// The building plan itself stays in the mapped file, only the header is copied out
+		const PlanHeader& header = building_plan.header();
+		nr_rows = header.nr_rows;
+		nr_columns = header.nr_columns;
+		router_radius = header.router_radius;
+		backbone_cost = header.backbone_cost;
+		router_cost = header.router_cost;
+		budget = header.budget;
+		initial_cell = make_pair(header.initial_row, header.initial_column);
 	}
 
-	void write_to_file(const string filename, pair<set<Point>, set<Point>> solution)
+	void write_to_file(const string filename, const pair<BackboneMap, set<Point>>& solution)
 	{
 		ofstream fout(filename);
-		auto backbone = solution.first;
-		fout << backbone.size() << '\n';
-		for (auto cell : backbone)
-			fout << cell.first << " " << cell.second << '\n';
+		solution.first.write(fout);
 
 		auto routers = solution.second;
 		fout << routers.size() << '\n';
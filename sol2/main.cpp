@@ -5,6 +5,7 @@
 #include <cstring>
 #include <cmath>
 #include <deque>
+#include <filesystem>
 #include <map>
 #include "Data.h"
 #include "Definitions.h"
@@ -85,17 +86,25 @@ public:
 	}
 };
 
-int main()
+int main(int argc, char** argv)
 {
 	const string in_prefix = "../../../input_files/";
 	const string out_prefix = "../../../output_files/sol2/";
 
 	const array<string, 4> input_files = { "charleston_road.in", "lets_go_higher.in", "opera.in", "rue_de_londres.in" };
 
-	for (string input_file : input_files)
+	// The four inputs above, or the single one given: sol2 <input file> <output file>
+	vector<pair<string, string>> jobs;
+	if (argc == 3)
+		jobs.emplace_back(argv[1], argv[2]);
+	else
+		for (const string& input_file : input_files)
+			jobs.emplace_back(in_prefix + input_file, out_prefix + input_file.substr(0, (input_file.find('.'))));
+
+	for (const auto& [input_path, output_path] : jobs)
 	{
-		cout << "Now working on " << input_file;
-		Data data(in_prefix + input_file);
+		cout << "Now working on " << filesystem::path(input_path).filename().string();
+		Data data(input_path);
 		cout << ". Input processed.\n";
 		
 		ComponentCalculator component_calculator(data);
@@ -106,7 +115,7 @@ int main()
 
 		auto raw_solution = solver.solve();
 		auto processed_solution = SolutionProcessor::process(data, raw_solution);
-		data.write_to_file(out_prefix + input_file.substr(0, (input_file.find('.'))), processed_solution);
+		data.write_to_file(output_path, processed_solution);
 	}
 	cout << "Final score = " << final_score << '\n';
 	return 0;
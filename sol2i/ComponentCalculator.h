@@ -6,34 +6,18 @@
 
 #include "Data.h"
 #include "Definitions.h"
+#include "../common/BitGrid.h"
+#include "../common/SummedAreaTable.h"
 
 class ComponentCalculator
 {
 private:
     const Data& data;
-    unique_ptr<unique_ptr<unsigned int[]>[]> nr_coverable_cells;
-    unique_ptr<unique_ptr<bool[]>[]> visited;
+    SummedAreaTable nr_coverable_cells;
+    BitGrid visited;
 
     bool can_place_router(int i, int j)
     {
-        const auto compute_rect_sum = [&](const Rectangle& matrix)
-        {
-            // rectangle [(0, 0), (i2, j2)]
-            unsigned int result = nr_coverable_cells[matrix.second.first][matrix.second.second];
-
-            // subtracting [(0, 0), (i1 - 1, j2)], which is the rectangle above		(1)
-            const int i1 = max(((int)matrix.first.first - 1), 0);
-            result -= nr_coverable_cells[i1][matrix.second.second];
-
-            // subtracting [(0, 0), (i2, j1 - 1)]									(2)
-            const int j1 = max(((int)matrix.first.second - 1), 0);
-            result -= nr_coverable_cells[matrix.second.first][j1];
-
-            // Adding the intersection between (1) and (2) which has been subtracted twice
-            //[(0, 0), (i1 - 1, j1 - 1)]
-            return result + nr_coverable_cells[i1][j1];
-        };
-
         const int upper_left_i = i - data.router_radius;
         const int upper_left_j = j - data.router_radius;
 
@@ -45,14 +29,10 @@ private:
             return false;
 
         // checking if all cells are unvisited
-        for (int i1 = upper_left_i; i1 <= bottom_right_i; ++i1)
-            for (int j1 = upper_left_j; j1 <= bottom_right_j; ++j1)
-                if (visited[i1][j1])
-                    return false;
-
-        const Point upper_left = make_pair(upper_left_i, upper_left_j);
-        const Point bottom_right = make_pair(bottom_right_i, bottom_right_j);
-        const auto nr_coverable_cells_in_matrix = compute_rect_sum(make_pair(upper_left, bottom_right));
+        if (visited.any_in_window(upper_left_i, upper_left_j, bottom_right_i, bottom_right_j))
+            return false;
+
+        const auto nr_coverable_cells_in_matrix = nr_coverable_cells.rect_sum(upper_left_i, upper_left_j, bottom_right_i, bottom_right_j);
         return nr_coverable_cells_in_matrix == (data.router_radius * 2 + 1) * (data.router_radius * 2 + 1);
     };
 
@@ -71,9 +51,7 @@ private:
             const unsigned int bottom_right_i = router_position.first + data.router_radius;
             const unsigned int bottom_right_j = router_position.second + data.router_radius;
 
-            for (unsigned int i = upper_left_i; i <= bottom_right_i; ++i)
-                for (unsigned int j = upper_left_j; j <= bottom_right_j; ++j)
-                    visited[i][j] = true;
+            visited.set_window(upper_left_i, upper_left_j, bottom_right_i, bottom_right_j);
         };
 
         const int di[4] = { 0, 0, 1, -1 };
@@ -160,31 +138,13 @@ public:
 
     ComponentCalculator(const Data& data): data{data}
     {
-        // Allocating memory
-        nr_coverable_cells = make_unique<unique_ptr<unsigned int[]>[]>(data.nr_rows);
-        for (unsigned int index = 0; index < data.nr_rows; ++index)
-            nr_coverable_cells[index] = make_unique<unsigned int[]>(data.nr_columns);
-
         // Determining the nr of cells which can be covered in any rectangle
-        for (unsigned int i = 0; i < data.nr_rows; ++i)
-            nr_coverable_cells[i][0] = (data.building_plan[i][0] == '.');
-
-        // First, determining line sum
-        for (unsigned int i = 0; i < data.nr_rows; ++i)
-            for (unsigned int j = 1; j < data.nr_columns; ++j)
-                nr_coverable_cells[i][j] = nr_coverable_cells[i][j - 1] + (data.building_plan[i][j] == '.');
-
-        // Second, determining rectangle sum
-        for (unsigned int j = 0; j < data.nr_columns; ++j)
-            for (unsigned int i = 1; i < data.nr_rows; ++i)
-                nr_coverable_cells[i][j] += nr_coverable_cells[i - 1][j];
-
-        visited = make_unique<unique_ptr<bool[]>[]>(data.nr_rows);
-        for (size_t index = 0; index < data.nr_rows; ++index)
+        nr_coverable_cells = SummedAreaTable(data.nr_rows, data.nr_columns, [&](int i, int j)
         {
-            visited[index] = make_unique<bool[]>(data.nr_columns);
-            memset(visited[index].get(), 0, data.nr_columns);
-        }
+            return data.building_plan[i][j] == '.';
+        });
+
+        visited = BitGrid(data.nr_rows, data.nr_columns);
     }
 
     vector<vector<Point>> get_components()
@@ -192,7 +152,7 @@ public:
         vector<vector<Point>> components;
         for (const auto& [i, j]: get_spiral_pattern())
         {
-            if (!visited[i][j] && data.building_plan[i][j] == '.')
+            if (!visited.test(i, j) && data.building_plan[i][j] == '.')
             {
                 const unsigned int router_pos_i = i + data.router_radius;
                 const unsigned int router_pos_j = j + data.router_radius;
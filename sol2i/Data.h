@@ -2,8 +2,11 @@
 #include <set>
 #include <iostream>
 #include <fstream>
+#include <memory>
 
 #include "Definitions.h"
+#include "../common/BuildingPlan.h"
+#include "../common/BackboneMap.h"
 
 using namespace std;
 
@@ -15,33 +18,26 @@ public:
 
     int nr_rows, nr_columns, router_radius, backbone_cost, router_cost, budget;
     Point initial_cell;
-    unique_ptr<unique_ptr<char[]>[]> building_plan;
+    BuildingPlan building_plan;
 
 
-    Data(const string& filename)
+    explicit Data(const string& filename): building_plan(filename)
     {
-        ifstream fin(filename);
-
-        fin >> nr_rows >> nr_columns >> router_radius >> backbone_cost >> router_cost >> budget;
-        fin >> initial_cell.first >> initial_cell.second;
-
-        // Allocating memory for the building plan
-        building_plan = make_unique<unique_ptr<char[]>[]>(nr_rows);
-        for (unsigned int index = 0; index < nr_rows; ++index)
-            building_plan[index] = make_unique<char[]>(nr_columns);
-
-        // Reading the building plan
-        for (unsigned int i = 0; i < nr_rows; ++i)
-            for (unsigned int j = 0; j < nr_columns; ++j)
-                fin >> building_plan[i][j];
+        // The building plan itself stays in the mapped file, only the header is copied out
+        const PlanHeader& header = building_plan.header();
+        nr_rows = header.nr_rows;
+        nr_columns = header.nr_columns;
+        router_radius = header.router_radius;
+        backbone_cost = header.backbone_cost;
+        router_cost = header.router_cost;
+        budget = header.budget;
+        initial_cell = {header.initial_row, header.initial_column};
     }
 
-    void write_to_file(const string& filename, const set<Point>& backbone, const set<Point>& routers) const
+    void write_to_file(const string& filename, const BackboneMap& backbone, const set<Point>& routers) const
     {
         ofstream fout(filename);
-        fout << backbone.size() << '\n';
-        for (const auto& cell : backbone)
-            fout << cell.first << " " << cell.second << '\n';
+        backbone.write(fout);
 
         fout << routers.size() << '\n';
         for (const auto& router : routers)
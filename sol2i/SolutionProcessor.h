@@ -1,99 +1,51 @@
 #pragma once
-#define NMAX 99999999
 #include <set>
 
-#include "kdtree.hpp"
-
-struct PointAccessor {
-    typedef double result_type;
-    double operator()(const Point& p, size_t dim) const {
-        return dim == 0 ? p.first : p.second;
-    }
-};
+#include "../common/BackboneIndex.h"
+#include "../common/SpanningBackbone.h"
 
 class SolutionProcessor
 {
 private:
     Data& data;
 
-    static unsigned int get_distance(const Point& a, const Point& b)
-    {
-        const int x_dist = abs((int)a.first - (int)b.first);
-        const int y_dist = abs((int)a.second - (int)b.second);
-
-        return max(x_dist, y_dist);
-    }
-
-    [[nodiscard]] bool is_valid(const Point& point) const
-    {
-        return (point.first < data.nr_rows && point.second < data.nr_columns);
-    }
-
-    vector<Point> get_all_backbone_cells_between_points(const Point& router1, const Point& router2)
-    {
-        const int di[8] = { 0, 0, 1, -1, -1, 1, 1, -1 };
-        const int dj[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
-
-        vector<Point> result{router1};
-        Point current_position = router1;
-
-        while (current_position != router2)
-        {
-            Point closest_new_point;
-            unsigned shortest_distance = NMAX;
-            for (unsigned int direction = 0; direction < 8; ++direction)
-            {
-                const int new_i = (int)current_position.first + di[direction];
-                const int new_j = (int)current_position.second + dj[direction];
-                Point new_point = {new_i, new_j};
-                const unsigned int new_distance = get_distance(new_point, router2);
-
-                if (is_valid(new_point) && new_distance < shortest_distance)
-                {
-                    shortest_distance = new_distance;
-                    closest_new_point = new_point;
-                }
-            }
-
-            result.push_back(closest_new_point);
-            current_position = closest_new_point;
-        }
-        return result;
-    }
-
 public:
     explicit SolutionProcessor(Data& data): data{data}
     {
     }
 
-    pair<set<Point>, set<Point>> process(const vector<Point>& raw_solution)
+    pair<BackboneMap, set<Point>> process(const vector<Point>& raw_solution)
     {
         int remaining_budget = data.budget;
 
-        KDTree::KDTree<2, Point, PointAccessor> tree;
-        tree.insert(data.initial_cell);
+        // The cables laid so far, to find the closest backbone/router cell
+        BackboneIndex backbone_index(data.nr_rows, data.nr_columns);
+        backbone_index.insert(data.initial_cell);
 
-        set<Point> backbone, routers;
+        // The initial cell is already connected, so it is on the map from the start and never paid for
+        BackboneMap backbone(data.nr_rows, data.nr_columns);
+        backbone.insert(data.initial_cell.first, data.initial_cell.second);
+        set<Point> routers;
 
         for (const auto& router : raw_solution)
         {
-            auto [nearest_it, distance] = tree.find_nearest(router);
-            auto backbone_cells_between_routers = get_all_backbone_cells_between_points(router, *nearest_it);
-            const int cost_to_add = data.router_cost + backbone_cells_between_routers.size() * data.backbone_cost;
+            const auto [nearest, distance] = backbone_index.find_nearest(router);
+            const int new_cells = backbone.count_new_cells(router.first, router.second, nearest.first, nearest.second);
+            const int cost_to_add = data.router_cost + new_cells * data.backbone_cost;
 
             if (cost_to_add <= remaining_budget)
             {
                 routers.insert(router);
-                tree.insert(router);
-                for (const auto& cell : backbone_cells_between_routers)
-                {
-                    backbone.insert(cell);
-                    tree.insert(cell);
-                }
+                // The cable starts at the router itself
+                backbone.lay_cable(router.first, router.second, nearest.first, nearest.second);
+                backbone_index.insert_cable(router, nearest);
                 remaining_budget -= cost_to_add;
             }
         }
-        backbone.erase(data.initial_cell);
-        return {backbone, routers};
+        const int freed_budget = spanning_backbone::rebuild(data, backbone, routers);
+        cout << "Budget freed by rebuilding the backbone: " << freed_budget << '\n';
+
+        backbone.erase(data.initial_cell.first, data.initial_cell.second);
+        return {std::move(backbone), routers};
     }
 };
\ No newline at end of file
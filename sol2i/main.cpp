@@ -2,6 +2,7 @@
 #include <array>
 #include <cassert>
 #include <thread>
+#include <filesystem>
 
 #include "Data.h"
 #include "ComponentCalculator.h"
@@ -10,16 +11,25 @@
 using namespace std;
 unsigned long long final_score = 0;
 
-int main()
+int main(int argc, char** argv)
 {
     const string in_prefix = "../../input_files/";
     const string out_prefix = "../../output_files/sol2i/";
 
     const array<string, 4> input_files = { "charleston_road.in", "lets_go_higher.in", "opera.in", "rue_de_londres.in" };
-    for (const string& input_file : input_files)
+
+    // The four inputs above, or the single one given: sol2i <input file> <output file>
+    vector<pair<string, string>> jobs;
+    if (argc == 3)
+        jobs.emplace_back(argv[1], argv[2]);
+    else
+        for (const string& input_file : input_files)
+            jobs.emplace_back(in_prefix + input_file, out_prefix + input_file.substr(0, (input_file.find('.'))));
+
+    for (const auto& [input_path, output_path] : jobs)
     {
-        cout << "Now working on " << input_file;
-        Data data(in_prefix + input_file);
+        cout << "Now working on " << filesystem::path(input_path).filename().string() << '\n';
+        Data data(input_path);
 
         ComponentCalculator component_calculator(data);
         const auto components = component_calculator.get_components();
@@ -40,7 +50,7 @@ int main()
         cout << "Cells covered: " << nr_cells_covered << ", Score: " << score << "\n\n";
         final_score += score;
 
-        data.write_to_file(out_prefix + input_file.substr(0, (input_file.find('.'))), backbone, routers);
+        data.write_to_file(output_path, backbone, routers);
     }
     cout << "Final score = " << final_score << '\n';
     return 0;
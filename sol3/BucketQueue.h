@@ -0,0 +1,167 @@
+#pragma once
+/*
+ * Max-priority queue over integer keys in [0, max_key], one bucket per key.
+ * Items are 32-bit ids (e.g. cell indices) with at most one entry each, so their key can be changed in place:
+ * every bucket is an intrusive doubly linked list threaded through per-id arrays, and no node is ever allocated.
+ * The non-empty buckets are marked in a bitmap with a summary bit per word, level above level up to a single word,
+ * so the highest one is found with one countl_zero per level (3 levels for a million keys) whatever the order of
+ * the keys: raising keys, as the eager rescoring of sol3 does, costs no rescan. Ids of equal keys come out in
+ * insertion order.
+ */
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class BucketQueue{
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    BucketQueue(uint32_t nr_ids, int max_key)
+    : head(max_key + 1, NONE)
+    , tail(max_key + 1, NONE)
+    , next(nr_ids, NONE)
+    , previous(nr_ids, NONE)
+    , key_of(nr_ids, ABSENT)
+    , nr_entries(0)
+    {
+        // Level 0 has a bit per key, every level above a bit per word of the one below
+        size_t nr_bits = (size_t)max_key + 1;
+        do
+        {
+            nr_bits = (nr_bits + WORD_BITS - 1) / WORD_BITS;
+            non_empty.emplace_back(nr_bits, 0);
+        } while (nr_bits > 1);
+    }
+
+    [[nodiscard]] bool contains(uint32_t id) const
+    {
+        return key_of[id] != ABSENT;
+    }
+
+    [[nodiscard]] int key(uint32_t id) const
+    {
+        return key_of[id];
+    }
+
+    // Inserts 'id', or moves it to 'new_key' (to the back of its bucket) if it is already queued
+    void update(uint32_t id, int new_key)
+    {
+        if (contains(id))
+        {
+            if (key_of[id] == new_key)
+                return;
+            unlink(id);
+        }
+        else
+            nr_entries++;
+        link(id, new_key);
+    }
+
+    void erase(uint32_t id)
+    {
+        if (!contains(id))
+            return;
+        unlink(id);
+        key_of[id] = ABSENT;
+        nr_entries--;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return nr_entries == 0;
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return nr_entries;
+    }
+
+    // The key and id of the highest entry (the earliest inserted among equal keys); the queue must not be empty
+    [[nodiscard]] std::pair<int, uint32_t> top() const
+    {
+        size_t index = 0;
+        for (size_t level = non_empty.size(); level-- > 0;)
+            index = index * WORD_BITS + (WORD_BITS - 1 - std::countl_zero(non_empty[level][index]));
+        return {(int)index, head[index]};
+    }
+
+    std::pair<int, uint32_t> pop()
+    {
+        const auto result = top();
+        erase(result.second);
+        return result;
+    }
+
+private:
+    static constexpr int ABSENT = -1;
+    static constexpr size_t WORD_BITS = 64;
+
+    // First and last id of every bucket
+    std::vector<uint32_t> head, tail;
+    // Neighbours of every id within its bucket
+    std::vector<uint32_t> next, previous;
+    std::vector<int> key_of;
+    // non_empty[0] has a bit set for every non-empty bucket, non_empty[l] for every non-zero word of non_empty[l - 1]
+    std::vector<std::vector<uint64_t>> non_empty;
+    size_t nr_entries;
+
+    void mark_non_empty(size_t key)
+    {
+        for (std::vector<uint64_t>& level : non_empty)
+        {
+            uint64_t& word = level[key / WORD_BITS];
+            const bool was_zero = word == 0;
+            word |= 1ull << (key % WORD_BITS);
+            // The levels above already have this word marked
+            if (!was_zero)
+                return;
+            key /= WORD_BITS;
+        }
+    }
+
+    void mark_empty(size_t key)
+    {
+        for (std::vector<uint64_t>& level : non_empty)
+        {
+            uint64_t& word = level[key / WORD_BITS];
+            word &= ~(1ull << (key % WORD_BITS));
+            if (word != 0)
+                return;
+            key /= WORD_BITS;
+        }
+    }
+
+    void link(uint32_t id, int new_key)
+    {
+        key_of[id] = new_key;
+        next[id] = NONE;
+        previous[id] = tail[new_key];
+        if (tail[new_key] == NONE)
+        {
+            head[new_key] = id;
+            mark_non_empty(new_key);
+        }
+        else
+            next[tail[new_key]] = id;
+        tail[new_key] = id;
+    }
+
+    void unlink(uint32_t id)
+    {
+        const int old_key = key_of[id];
+        if (previous[id] == NONE)
+            head[old_key] = next[id];
+        else
+            next[previous[id]] = next[id];
+        if (next[id] == NONE)
+            tail[old_key] = previous[id];
+        else
+            previous[next[id]] = previous[id];
+
+        if (head[old_key] == NONE)
+            mark_empty(old_key);
+    }
+};
@@ -0,0 +1,95 @@
+#pragma once
+/*
+ * Queue of router candidates: at most one entry per cell, keyed on its score gain, highest first.
+ * The bulk fill done from a parallel loop goes to one buffer per thread or per task, so they never share a lock
+ * or a cache line; the buffers are then queued one after the other. Cells are stored as 32-bit indices in a BucketQueue,
+ * since scores are bounded by the number of cells a router can cover.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "BucketQueue.h"
+#include "Definitions.h"
+
+class CandidateQueue{
+public:
+    // Scores must lie in [0, max_score]
+    CandidateQueue(int nr_rows, int nr_columns, int max_score)
+    : nr_columns(nr_columns)
+    , queue((uint32_t)nr_rows * nr_columns, max_score)
+    {
+    }
+
+    // Starts a bulk fill into nr_buffers buffers, each one filled by a single thread at a time
+    void begin_bulk_push(int nr_buffers)
+    {
+        buffers.resize(nr_buffers);
+        for (auto& buffer : buffers)
+            buffer.candidates.clear();
+    }
+
+    // Only one thread may push to a given buffer, so no synchronization is needed
+    void bulk_push(int buffer, int score, const Point& point)
+    {
+        buffers[buffer].candidates.emplace_back(score, index_of(point));
+    }
+
+    // Queues the buffered candidates, buffer by buffer: with one buffer per band of rows, this is row-major order.
+    // Serial, as the buckets are shared linked lists; only the collection of the candidates is parallel
+    void end_bulk_push()
+    {
+        for (const auto& buffer : buffers)
+            for (const auto& [score, index] : buffer.candidates)
+                queue.update(index, score);
+    }
+
+    // Queues 'point' with 'score', or changes the score it is queued with
+    void update(const Point& point, int score)
+    {
+        queue.update(index_of(point), score);
+    }
+
+    void erase(const Point& point)
+    {
+        queue.erase(index_of(point));
+    }
+
+    // Takes out the candidate with the highest score
+    bool pop(std::pair<int, Point>& out)
+    {
+        if (queue.empty())
+            return false;
+        const auto [score, index] = queue.pop();
+        out = {score, {(int)(index / nr_columns), (int)(index % nr_columns)}};
+        return true;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return queue.empty();
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return queue.size();
+    }
+
+private:
+    // Each buffer on its own cache lines, so that concurrent push_backs don't false share
+    struct alignas(64) Buffer
+    {
+        std::vector<std::pair<int, uint32_t>> candidates;
+    };
+
+    int nr_columns;
+    BucketQueue queue;
+    std::vector<Buffer> buffers;
+
+    [[nodiscard]] uint32_t index_of(const Point& point) const
+    {
+        return (uint32_t)point.first * nr_columns + point.second;
+    }
+};
@@ -6,13 +6,14 @@
 
 #include "Data.h"
 #include "Definitions.h"
+#include "../common/BitGrid.h"
 
 class ComponentCalculator
 {
 private:
     const Data& data;
-    unique_ptr<unique_ptr<unsigned int[]>[]> nr_coverable_cells;
-    unique_ptr<unique_ptr<bool[]>[]>& visited;
+    SummedAreaTable nr_coverable_cells;
+    BitGrid& visited;
 
     bool can_place_router(int i, int j)
     {
@@ -28,10 +29,8 @@ private:
                 return false;
 
         // checking if all cells are unvisited
-        for (int i1 = upper_left_i; i1 <= bottom_right_i; ++i1)
-            for (int j1 = upper_left_j; j1 <= bottom_right_j; ++j1)
-                if (visited[i1][j1])
-                    return false;
+        if (visited.any_in_window(upper_left_i, upper_left_j, bottom_right_i, bottom_right_j))
+            return false;
 
         const Point upper_left = make_pair(upper_left_i, upper_left_j);
         const Point bottom_right = make_pair(bottom_right_i, bottom_right_j);
@@ -54,9 +53,7 @@ private:
             const unsigned int bottom_right_i = router_position.first + data.router_radius;
             const unsigned int bottom_right_j = router_position.second + data.router_radius;
 
-            for (unsigned int i = upper_left_i; i <= bottom_right_i; ++i)
-                for (unsigned int j = upper_left_j; j <= bottom_right_j; ++j)
-                    visited[i][j] = true;
+            visited.set_window(upper_left_i, upper_left_j, bottom_right_i, bottom_right_j);
         };
 
         const int di[4] = { 0, 0, 1, -1 };
@@ -141,28 +138,15 @@ private:
 
 public:
 
-    ComponentCalculator(const Data& data, unique_ptr<unique_ptr<bool[]>[]>& visited)
+    ComponentCalculator(const Data& data, BitGrid& visited)
     : data(data)
     , visited(visited)
     {
-        // Allocating memory
-        nr_coverable_cells = make_unique<unique_ptr<unsigned int[]>[]>(data.nr_rows);
-        for (unsigned int index = 0; index < data.nr_rows; ++index)
-            nr_coverable_cells[index] = make_unique<unsigned int[]>(data.nr_columns);
-
         // Determining the nr of cells which can be covered in any rectangle
-        for (unsigned int i = 0; i < data.nr_rows; ++i)
-            nr_coverable_cells[i][0] = (data.building_plan[i][0] == '.');
-
-        // First, determining line sum
-        for (unsigned int i = 0; i < data.nr_rows; ++i)
-            for (unsigned int j = 1; j < data.nr_columns; ++j)
-                nr_coverable_cells[i][j] = nr_coverable_cells[i][j - 1] + (data.building_plan[i][j] == '.');
-
-        // Second, determining rectangle sum
-        for (unsigned int j = 0; j < data.nr_columns; ++j)
-            for (unsigned int i = 1; i < data.nr_rows; ++i)
-                nr_coverable_cells[i][j] += nr_coverable_cells[i - 1][j];
+        nr_coverable_cells = SummedAreaTable(data.nr_rows, data.nr_columns, [&](int i, int j)
+        {
+            return data.building_plan[i][j] == '.';
+        });
     }
 
     vector<Point> get_perfect_routers()
@@ -170,7 +154,7 @@ public:
         vector<Point> perfect_routers;
         for (const auto& [i, j]: get_spiral_pattern())
         {
-            if (!visited[i][j] && data.building_plan[i][j] == '.')
+            if (!visited.test(i, j) && data.building_plan[i][j] == '.')
             {
                 const unsigned int router_pos_i = i + data.router_radius;
                 const unsigned int router_pos_j = j + data.router_radius;
@@ -5,25 +5,15 @@
 
 #include <iostream>
 
+#include "../common/SummedAreaTable.h"
+
 using Point = std::pair<int, int>;
 using Rectangle = std::pair<Point, Point>;
 
-inline unsigned int compute_rect_sum(const Rectangle& rectangle, const std::unique_ptr<std::unique_ptr<unsigned int[]>[]>& int_map)
+inline unsigned int compute_rect_sum(const Rectangle& rectangle, const SummedAreaTable& int_map)
 {
-    // rectangle [(0, 0), (i2, j2)]
-    unsigned int result = int_map[rectangle.second.first][rectangle.second.second];
-
-    // subtracting [(0, 0), (i1 - 1, j2)], which is the rectangle above		(1)
-    const int i1 = std::max(((int)rectangle.first.first - 1), 0);
-    result -= int_map[i1][rectangle.second.second];
-
-    // subtracting [(0, 0), (i2, j1 - 1)]									(2)
-    const int j1 = std::max(((int)rectangle.first.second - 1), 0);
-    result -= int_map[rectangle.second.first][j1];
-
-    // Adding the intersection between (1) and (2) which has been subtracted twice
-    //[(0, 0), (i1 - 1, j1 - 1)]
-    return result + int_map[i1][j1];
+    // The table is zero-padded on the top and left, so no clamping is needed at the map border
+    return int_map.rect_sum(rectangle.first.first, rectangle.first.second, rectangle.second.first, rectangle.second.second);
 };
 
 inline bool is_valid(const Point& point, const int nr_rows, const int nr_columns)
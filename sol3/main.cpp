@@ -1,14 +1,22 @@
-#include <omp.h>
 #include <iostream>
 #include <array>
 #include <cassert>
-#include <thread>
+#include <atomic>
+#include <vector>
+#include <optional>
+#include <filesystem>
 
 #include "Data.h"
 #include "ComponentCalculator.h"
 #include "SolutionProcessor.h"
-#include "SafePriorityQueue.h"
+#include "CandidateQueue.h"
 #include "Definitions.h"
+#include "../common/Grid.h"
+#include "../common/BitGrid.h"
+#include "../common/CoverageKernel.h"
+#include "../common/CoverageCounter.h"
+#include "../common/ChebyshevDistanceMap.h"
+#include "../common/ThreadPool.h"
 
 using namespace std;
 
@@ -18,196 +26,190 @@ private:
     Data& data;
     int remaining_budget;
     unsigned int nr_cells_covered;
-    unique_ptr<unique_ptr<unsigned int[]>[]> wall_map, nr_coverable_cells;
-    unique_ptr<unique_ptr<bool[]>[]> visited;
+    Grid<unsigned int> nr_coverable_cells;
+    // walls holds the '#' cells, targets the '.' cells, visited the ones already covered by a router
+    BitGrid walls, targets, visited;
+    CoverageKernel coverage_kernel;
+    // Cells covered by the last router placed, reused across updates
+    vector<Point> newly_covered_points;
+    // score_version[i][j] changes whenever the score of a router at (i, j) may have changed, and
+    // scored_version[i][j] is the version its queued score was computed from
+    Grid<unsigned int> score_version, scored_version;
 
-    bool is_any_wall_between(const Point& point1, const Point& point2)
+    void initialize_coverable_cells()
     {
-        const Point upper_left = { std::min(point1.first, point2.first), std::min(point1.second, point2.second) };
-        const Point bottom_right = { std::max(point1.first, point2.first), std::max(point1.second, point2.second) };
+        const CoverageCounter counter(walls, targets, data.router_radius, &visited);
+        const auto can_place_router = [&](int i, int j) { return data.building_plan[i][j] == '.'; };
 
-        return compute_rect_sum({upper_left, bottom_right}, wall_map);
+        // Tasks take bands of rows; all the routers of a row share the same column sweeps
+        constexpr int band_height = 8;
+        const int nr_bands = (data.nr_rows + band_height - 1) / band_height;
+        ThreadPool::global().parallel_for(0, nr_bands, 1, [&](size_t band)
+        {
+            const int band_start = (int)band * band_height;
+            const int band_end = min(data.nr_rows, band_start + band_height) - 1;
+            counter.count_window(nr_coverable_cells, band_start, 0, band_end, data.nr_columns - 1, can_place_router);
+        });
     }
 
-    void initialize_wall_map()
+    // Score gain of a router at 'point' connected to the closest backbone/router, or nullopt if it is not worth it
+    optional<int> evaluate_candidate(const Point& point, const ChebyshevDistanceMap& backbone_distance) const
     {
-        // Allocating memory
-        wall_map = make_unique<unique_ptr<unsigned int[]>[]>(data.nr_rows);
-        for (unsigned int index = 0; index < data.nr_rows; ++index)
-            wall_map[index] = make_unique<unsigned int[]>(data.nr_columns);
-
-        for (unsigned int i = 0; i < data.nr_rows; ++i)
-            wall_map[i][0] = (data.building_plan[i][0] == '#');
-
-        // First, determining line sum
-        for (unsigned int i = 0; i < data.nr_rows; ++i)
-            for (unsigned int j = 1; j < data.nr_columns; ++j)
-                wall_map[i][j] = wall_map[i][j - 1] + (data.building_plan[i][j] == '#');
-
-        // Second, determining rectangle sum
-        for (unsigned int j = 0; j < data.nr_columns; ++j)
-            for (unsigned int i = 1; i < data.nr_rows; ++i)
-                wall_map[i][j] += wall_map[i - 1][j];
+        const unsigned int distance = backbone_distance.distance(point.first, point.second);
+
+        const int cost = (data.router_cost + data.backbone_cost * (int) distance);
+        const int score_gain = ((int) nr_coverable_cells[point.first][point.second] * 1000 - cost);
+
+        if (score_gain > 0 && cost <= remaining_budget)
+            return score_gain;
+        return nullopt;
     }
 
-    void initialize_coverable_cells()
+    void populate_pqueue_parallel(CandidateQueue& pq, const ChebyshevDistanceMap& backbone_distance)
     {
-        #pragma omp parallel for
-        for (int i = 0; i < data.nr_rows; ++i)
+        // One buffer per band of rows, so the candidates are queued in row-major order whichever thread ran the band
+        constexpr int band_height = 16;
+        const int nr_bands = (data.nr_rows + band_height - 1) / band_height;
+        pq.begin_bulk_push(nr_bands);
+        ThreadPool::global().parallel_for(0, nr_bands, 1, [&](size_t band)
         {
-            for (int j = 0; j < data.nr_columns; ++j)
-            {
-                // Could place a router here
-                if (data.building_plan[i][j] == '.')
+            for (int i = (int)band * band_height; i < min(data.nr_rows, ((int)band + 1) * band_height); ++i)
+                for (int j = 0; j < data.nr_columns; ++j)
                 {
-                    int sum = 0;
-                    for (int x = max(0, i - data.router_radius); x <= min(data.nr_rows - 1, i + data.router_radius); ++x)
+                    if (data.building_plan[i][j] == '.')
                     {
-                        for (int y = max(0, j - data.router_radius); y <= min(data.nr_columns - 1, j + data.router_radius); ++y)
-                        {
-                            if (data.building_plan[x][y] == '.' && !visited[x][y] && !is_any_wall_between({i, j}, {x, y}))
-                                sum++;
-                        }
+                        // Scored afresh, so entries marked stale before the queue was rebuilt are no longer
+                        scored_version[i][j] = score_version[i][j];
+                        if (const auto score_gain = evaluate_candidate({i, j}, backbone_distance))
+                            pq.bulk_push(band, *score_gain, {i, j});
                     }
-                    nr_coverable_cells[i][j] = sum;
                 }
-                else
-                    nr_coverable_cells[i][j] = 0;
-            }
-        }
+        });
+        pq.end_bulk_push();
     }
 
-    void populate_pqueue_parallel(ThreadSafePriorityQueue& pq, const KDTree::KDTree<2, Point, PointAccessor>& tree)
+    // Re-scores (i, j) and moves its queue entry accordingly
+    void rescore_candidate(int i, int j, CandidateQueue& pq, const ChebyshevDistanceMap& backbone_distance)
     {
-        #pragma omp parallel for
-        for (int i = 0; i < data.nr_rows; ++i)
-        {
-            for (int j = 0; j < data.nr_columns; ++j)
-            {
-                if (data.building_plan[i][j] == '.')
-                {
+        scored_version[i][j] = score_version[i][j];
+        if (const auto score_gain = evaluate_candidate({i, j}, backbone_distance))
+            pq.update({i, j}, *score_gain);
+        else
+            pq.erase({i, j});
+    }
 
-                    // Find the closest backbone/router to this position
-                    const auto [nearest_it, _] = tree.find_nearest(make_pair(i, j));
-                    const unsigned int distance = get_distance({i, j}, *nearest_it);
+    // Marks the candidates whose score changed after placing 'router' with the new 'backbone_cells'
+    void mark_dirty_regions(const Point& router, const vector<Point>& backbone_cells,
+                            CandidateQueue& pq, ChebyshevDistanceMap& backbone_distance)
+    {
+        const int reach = 2 * data.router_radius;
 
-                    const int cost = (data.router_cost + data.backbone_cost * (int) distance);
-                    const int score_gain = ((int) nr_coverable_cells[i][j] * 1000 - cost);
+        // Coverage only went down around the router, so the queued scores there are still upper bounds:
+        // they just become stale, and are re-evaluated if they ever reach the top
+        for (int i = max(0, router.first - reach); i <= min(data.nr_rows - 1, router.first + reach); ++i)
+            for (int j = max(0, router.second - reach); j <= min(data.nr_columns - 1, router.second + reach); ++j)
+                score_version[i][j]++;
 
-                    if (score_gain > 0 && cost <= remaining_budget)
-                        pq.push({score_gain, {i, j}});
-                }
-            }
-        }
+        // Candidates which got closer to the backbone got cheaper, and a raised score would never surface
+        // through a stale entry, so they are re-scored right away
+        backbone_distance.add_sources(backbone_cells, [&](int i, int j)
+        {
+            if (data.building_plan[i][j] == '.')
+                rescore_candidate(i, j, pq, backbone_distance);
+        });
     }
 
     void update_visited_and_coverage(const Point& point)
     {
-        std::set<Point> newly_covered_points;
-
         // Update visited in an R radius around the point
-        for (int i = point.first - data.router_radius; i <= point.first + data.router_radius; ++i)
+        newly_covered_points.clear();
+        CoverageMask mask;
+        coverage_kernel.compute(point.first, point.second, mask, &visited);
+        mask.for_each_cell([&](int i, int j)
         {
-            for (int j = point.second - data.router_radius; j <= point.second + data.router_radius; ++j)
-            {
-                if (data.building_plan[i][j] == '.' && !is_any_wall_between(point, {i, j}) && !visited[i][j])
-                {
-                    newly_covered_points.insert({i, j});
-                    visited[i][j] = true;
-                }
-            }
-        }
+            newly_covered_points.emplace_back(i, j);
+            visited.set(i, j);
+        });
 
         // Update nr_coverable_cells
-        for (int i = max(0, point.first - 2 * data.router_radius); i <= min(data.nr_rows - 1, point.first + 2 * data.router_radius); ++i)
+        // Visibility is symmetric, so the candidates that could cover (x, y) are exactly the '.' cells
+        // a router placed at (x, y) would cover: one kernel call per newly covered cell, instead of
+        // checking every candidate of the 2R neighbourhood against every newly covered cell
+        // Chunks of cells per task; small updates fit in one chunk and stay on this thread
+        constexpr size_t min_cells_per_task = 64;
+        ThreadPool::global().parallel_for_chunks(0, newly_covered_points.size(), min_cells_per_task, [&](size_t begin, size_t end)
         {
-            for (int j = max(0, point.second - 2 * data.router_radius); j <= min(data.nr_columns - 1, point.second + 2 * data.router_radius); ++j)
+            CoverageMask seen_by;
+            for (size_t index = begin; index < end; ++index)
             {
-                for (const auto& [x, y] : newly_covered_points)
+                const auto [x, y] = newly_covered_points[index];
+                coverage_kernel.compute(x, y, seen_by);
+                seen_by.for_each_cell([&](int i, int j)
                 {
                     // Decrement the number of coverable cells for a theoretical router placed at (i, j)
-                    // if (i, j) could cover (x, y)
-                    if (data.building_plan[i][j] == '.' && !is_any_wall_between({i, j}, {x, y}) && nr_coverable_cells[i][j] > 0)
-                        nr_coverable_cells[i][j]--;
-                }
+                    atomic_ref<unsigned int> nr_coverable(nr_coverable_cells[i][j]);
+                    unsigned int current = nr_coverable.load(memory_order_relaxed);
+                    while (current > 0 && !nr_coverable.compare_exchange_weak(current, current - 1, memory_order_relaxed));
+                });
             }
-        }
+        });
     }
 
-    void add_new_routers(std::set<Point>& backbone, std::set<Point>& routers, KDTree::KDTree<2, Point, PointAccessor>& tree)
+    void add_new_routers(BackboneMap& backbone, std::set<Point>& routers, ChebyshevDistanceMap& backbone_distance)
     {
-        ThreadSafePriorityQueue pq;
-        // This k-d tree will only contain routers, while the 'tree' variable contains backbone too
-        KDTree::KDTree<2, Point, PointAccessor> all_routers;
-        for (const auto& router : routers)
-            all_routers.insert(router);
-
-        while (remaining_budget >= 0)
+        // Lazy greedy: every candidate is scored once up front, and afterwards only when its score may have changed
+        // Scores are bounded by the number of cells a router can cover
+        const int max_score = (2 * data.router_radius + 1) * (2 * data.router_radius + 1) * 1000;
+        CandidateQueue pq(data.nr_rows, data.nr_columns, max_score);
+        populate_pqueue_parallel(pq, backbone_distance);
+
+        // Only the routers, while backbone_distance accounts for the backbone too
+        BitGrid router_cells(data.nr_rows, data.nr_columns);
+        for (const auto& [i, j] : routers)
+            router_cells.set(i, j);
+
+        std::pair<int, Point> res;
+        while (pq.pop(res))
         {
-            populate_pqueue_parallel(pq, tree);
-            KDTree::KDTree<2, Point, PointAccessor> new_routers_tree;
+            const auto [est_score_gain, new_router_point] = res;
+            const auto [i, j] = new_router_point;
 
-            bool router_was_added = false;
-            while (!pq.empty())
+            // Stale: re-evaluate, and queue it again with its current score
+            if (scored_version[i][j] != score_version[i][j])
             {
-                std::pair<int, Point> res;
-                pq.pop(res);
-                auto [est_score_per_point, new_router_point] = res;
+                rescore_candidate(i, j, pq, backbone_distance);
+                continue;
+            }
 
-                const auto [closest_router_it, _] = new_routers_tree.find_nearest(new_router_point);
-                const auto closest_router_distance = get_distance(new_router_point, *closest_router_it);
+            // No other router right next to it
+            if (router_cells.any_in_window(max(0, i - 1), max(0, j - 1), min(data.nr_rows - 1, i + 1), min(data.nr_columns - 1, j + 1)))
+                continue;
 
-                const auto [closest_old_router_it, __] = all_routers.find_nearest(new_router_point);
-                const auto closest_old_router_distance = get_distance(new_router_point, *closest_old_router_it);
+            // Find the closest backbone/router to connect it to
+            const Point closest_backbone = backbone_distance.nearest(i, j);
 
-                // No overlap with newly added routers
-                if ((new_routers_tree.empty() || closest_router_distance > 2 * data.router_radius) &&
-                        closest_old_router_distance >= 2)
-                {
-                    // Find the closest backbone/router to connect it to
-                    const auto [closest_backbone_it, _] = tree.find_nearest(new_router_point);
+            // Some of the cells of the cable might already be part of the backbone
+            const int cost_to_add = data.router_cost +
+                                    (int) backbone.count_new_cells(i, j, closest_backbone.first, closest_backbone.second) * data.backbone_cost;
 
-                    auto backbone_cells_between_routers =
-                            SolutionProcessor::get_all_backbone_cells_between_points(new_router_point,
-                                                                                     *closest_backbone_it,
-                                                                                     data.nr_rows,
-                                                                                     data.nr_columns);
+            // Add the new router if we can afford it
+            if (cost_to_add > remaining_budget)
+                continue;
 
-                    const int approx_cost_to_add = data.router_cost + backbone_cells_between_routers.size() * data.backbone_cost;
+            routers.insert(new_router_point);
+            router_cells.set(i, j);
 
-                    // Add the new router if we can afford it
-                    if (approx_cost_to_add <= remaining_budget)
-                    {
-                        routers.insert(new_router_point);
-                        tree.insert(new_router_point);
-                        new_routers_tree.insert(new_router_point);
-                        all_routers.insert(new_router_point);
-
-                        int actual_backbone_needed = 0;
-                        for (const auto &cell: backbone_cells_between_routers)
-                        {
-                            auto [_, insertion_happened] = backbone.insert(cell);
-                            if (insertion_happened)
-                                actual_backbone_needed++;
-
-                            tree.insert(cell);
-                        }
-                        // Some of the backbone cells might already be inserted
-                        const int exact_cost_to_add = data.router_cost + actual_backbone_needed * data.backbone_cost;
-                        remaining_budget -= exact_cost_to_add;
-                        nr_cells_covered += nr_coverable_cells[new_router_point.first][new_router_point.second];
-
-                        // Update visited[i][j] in radius R, and nr_coverable_cells in radius 2 * R
-                        // with respect to the newly added router
-                        update_visited_and_coverage(new_router_point);
-
-                        // Something was added this iteration, so it's worth to re-populate the pq
-                        router_was_added = true;
-                    }
-                }
-            }
-            if (!router_was_added)
-                break;
+            vector<Point> new_backbone_cells;
+            backbone.lay_cable(i, j, closest_backbone.first, closest_backbone.second,
+                               [&](int x, int y) { new_backbone_cells.emplace_back(x, y); });
+            remaining_budget -= cost_to_add;
+            nr_cells_covered += nr_coverable_cells[i][j];
+
+            // Update visited[i][j] in radius R, and nr_coverable_cells in radius 2 * R
+            // with respect to the newly added router
+            update_visited_and_coverage(new_router_point);
+
+            mark_dirty_regions(new_router_point, new_backbone_cells, pq, backbone_distance);
         }
     }
 
@@ -217,24 +219,18 @@ public:
     : data(data)
     , remaining_budget(data.budget)
     , nr_cells_covered(0)
+    , nr_coverable_cells(data.nr_rows, data.nr_columns)
+    , walls(data.nr_rows, data.nr_columns, [&](int i, int j) { return data.building_plan[i][j] == '#'; })
+    , targets(data.nr_rows, data.nr_columns, [&](int i, int j) { return data.building_plan[i][j] == '.'; })
+    , visited(data.nr_rows, data.nr_columns)
+    , coverage_kernel(walls, targets, data.router_radius)
+    , score_version(data.nr_rows, data.nr_columns, 0)
+    , scored_version(data.nr_rows, data.nr_columns, 0)
     {
-        initialize_wall_map();
-
-        // Allocate memory and initialize the visited map to false
-        visited = make_unique<unique_ptr<bool[]>[]>(data.nr_rows);
-        for (size_t index = 0; index < data.nr_rows; ++index)
-        {
-            visited[index] = make_unique<bool[]>(data.nr_columns);
-            memset(visited[index].get(), 0, data.nr_columns);
-        }
-
-        // Allocate memory for the coverable cells map
-        nr_coverable_cells = make_unique<unique_ptr<unsigned int[]>[]>(data.nr_rows);
-        for (unsigned int index = 0; index < data.nr_rows; ++index)
-            nr_coverable_cells[index] = make_unique<unsigned int[]>(data.nr_columns);
+        newly_covered_points.reserve((2 * data.router_radius + 1) * (2 * data.router_radius + 1));
     }
 
-    tuple<set<Point>, set<Point>> solve()
+    tuple<BackboneMap, set<Point>> solve()
     {
         // Step 1: obtain the 'perfect' router locations (no walls in range, no overlap whatsoever)
         // (also updates the visited map)
@@ -242,46 +238,67 @@ public:
         const auto perfect_routers = comp_calc->get_perfect_routers();
         comp_calc.reset();
 
-        // Step 2: process the routers so far, obtain the backbone coords, and a k-d tree containing the routers
+        // Step 2: process the routers so far, obtain the backbone coords, and the distance map to the backbone
         auto sol_proc = std::make_unique<SolutionProcessor>(data);
-        auto [backbone, routers, tree] = sol_proc->process(perfect_routers);
+        auto [backbone, routers, backbone_distance] = sol_proc->process(perfect_routers);
         assert(perfect_routers.size() == routers.size());
         sol_proc.reset();
 
         // Update the cells covered, and the remaining budget after adding the perfect routers
         nr_cells_covered = routers.size() * (data.router_radius * 2 + 1) * (data.router_radius * 2 + 1);
-        remaining_budget = data.budget - (routers.size() * data.router_cost + backbone.size() * data.backbone_cost);
+        // (the initial cell is on the backbone map, but it is free)
+        remaining_budget = data.budget - (routers.size() * data.router_cost + (backbone.size() - 1) * data.backbone_cost);
 
         // Initialize coverable cells map based on the perfect routers found so far
         initialize_coverable_cells();
 
         // Step 3: add new routers
-        add_new_routers(backbone, routers, tree);
+        add_new_routers(backbone, routers, backbone_distance);
 
-        auto to_set = [](const auto& container){
-            return std::set(container.begin(), container.end());
-        };
+        // Step 4: rebuild the backbone as a spanning tree of the routers, and spend what it frees on more routers
+        int total_freed_budget = 0;
+        while (const int freed_budget = spanning_backbone::rebuild(data, backbone, routers))
+        {
+            total_freed_budget += freed_budget;
+            remaining_budget += freed_budget;
+            backbone_distance.build([&](int i, int j) { return backbone.contains(i, j); });
+
+            const size_t nr_routers = routers.size();
+            add_new_routers(backbone, routers, backbone_distance);
+            if (routers.size() == nr_routers)
+                break;
+        }
+        cout << "Budget freed by rebuilding the backbone: " << total_freed_budget << std::endl;
 
         // Remove the original backbone start, since it is redundant to add it to output
-        backbone.erase(data.initial_cell);
-        return {to_set(backbone), to_set(routers)};
+        backbone.erase(data.initial_cell.first, data.initial_cell.second);
+        return {std::move(backbone), routers};
     }
 };
 
-int main()
+int main(int argc, char** argv)
 {
     const string in_prefix = "../../input_files/";
     const string out_prefix = "../../output_files/sol3/";
 
     const array<string, 4> input_files = { "charleston_road.in", "lets_go_higher.in", "opera.in", "rue_de_londres.in" };
-    for (const string& input_file : input_files)
+
+    // The four inputs above, or the single one given: sol3 <input file> <output file>
+    vector<pair<string, string>> jobs;
+    if (argc == 3)
+        jobs.emplace_back(argv[1], argv[2]);
+    else
+        for (const string& input_file : input_files)
+            jobs.emplace_back(in_prefix + input_file, out_prefix + input_file.substr(0, (input_file.find('.'))));
+
+    for (const auto& [input_path, output_path] : jobs)
     {
-        cout << "Now working on " << input_file << std::endl;
-        Data data(in_prefix + input_file);
+        cout << "Now working on " << filesystem::path(input_path).filename().string() << std::endl;
+        Data data(input_path);
         Solver solver(data);
         auto [backbone, routers] = solver.solve();
 
-        data.write_to_file(out_prefix + input_file.substr(0, (input_file.find('.'))), backbone, routers);
+        data.write_to_file(output_path, backbone, routers);
     }
     return 0;
 }
\ No newline at end of file
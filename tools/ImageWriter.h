@@ -0,0 +1,274 @@
+#pragma once
+/*
+ * Palette images written one row at a time, without any image library: binary PPM, or PNG.
+ * The PNG data is deflated on the fly with the fixed Huffman codes, matching only runs of the previous byte and
+ * of the row above (which is what plans and scaled-up pixels are made of), so a row is encoded from itself and
+ * the row before it, and only those two rows and a 64 KB output chunk are ever held in memory.
+ */
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The palette entries are 0xRRGGBB
+class ImageWriter
+{
+public:
+    virtual ~ImageWriter() = default;
+
+    // 'pixels' holds one palette index per pixel of the row; rows come top to bottom
+    virtual void write_row(const uint8_t* pixels) = 0;
+
+    // Must be called after the last row
+    virtual void finish() = 0;
+};
+
+class PpmWriter : public ImageWriter
+{
+private:
+    std::ofstream out;
+    std::vector<uint32_t> palette;
+    std::vector<char> rgb_row;
+
+public:
+    PpmWriter(const std::string& filename, size_t width, size_t height, std::vector<uint32_t> palette)
+    : out(filename, std::ios::binary)
+    , palette(std::move(palette))
+    , rgb_row(3 * width)
+    {
+        if (!out)
+            throw std::runtime_error("Could not create " + filename);
+        out << "P6\n" << width << ' ' << height << "\n255\n";
+    }
+
+    void write_row(const uint8_t* pixels) override
+    {
+        for (size_t x = 0; x < rgb_row.size() / 3; ++x)
+        {
+            const uint32_t color = palette[pixels[x]];
+            rgb_row[3 * x] = (char)(color >> 16);
+            rgb_row[3 * x + 1] = (char)(color >> 8);
+            rgb_row[3 * x + 2] = (char)color;
+        }
+        out.write(rgb_row.data(), rgb_row.size());
+    }
+
+    void finish() override
+    {
+        out.flush();
+    }
+};
+
+class PngWriter : public ImageWriter
+{
+private:
+    static constexpr size_t CHUNK_SIZE = 1 << 16;
+    static constexpr size_t MAX_DISTANCE = 32768;
+    static constexpr size_t MIN_MATCH = 3, MAX_MATCH = 258;
+
+    std::ofstream out;
+    size_t width;
+
+    // Scanlines as deflated: a filter byte (always 0, none) then the pixels
+    std::vector<uint8_t> previous_scanline, scanline;
+    bool has_previous = false;
+
+    // Deflate output, LSB first, flushed to an IDAT chunk whenever CHUNK_SIZE bytes are ready
+    std::vector<uint8_t> idat;
+    uint64_t bit_buffer = 0;
+    unsigned int nr_bits = 0;
+    uint32_t adler_a = 1, adler_b = 0;
+
+    static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0)
+    {
+        static const std::array<uint32_t, 256> table = []
+        {
+            std::array<uint32_t, 256> entries{};
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                entries[n] = c;
+            }
+            return entries;
+        }();
+
+        crc = ~crc;
+        for (size_t index = 0; index < length; ++index)
+            crc = table[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    static void append_u32(std::vector<uint8_t>& bytes, uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            bytes.push_back((uint8_t)(value >> shift));
+    }
+
+    void write_chunk(const char* type, const std::vector<uint8_t>& data)
+    {
+        std::vector<uint8_t> chunk;
+        chunk.reserve(data.size() + 12);
+        append_u32(chunk, (uint32_t)data.size());
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        append_u32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+        out.write((const char*)chunk.data(), chunk.size());
+    }
+
+    void put_bits(uint32_t bits, unsigned int count)
+    {
+        bit_buffer |= (uint64_t)bits << nr_bits;
+        nr_bits += count;
+        while (nr_bits >= 8)
+        {
+            idat.push_back((uint8_t)bit_buffer);
+            bit_buffer >>= 8;
+            nr_bits -= 8;
+        }
+        if (idat.size() >= CHUNK_SIZE)
+        {
+            write_chunk("IDAT", idat);
+            idat.clear();
+        }
+    }
+
+    // Huffman codes go most significant bit first
+    void put_code(uint32_t code, unsigned int length)
+    {
+        uint32_t reversed = 0;
+        for (unsigned int bit = 0; bit < length; ++bit)
+            reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+        put_bits(reversed, length);
+    }
+
+    // Fixed literal/length code of 'symbol' (0-287)
+    void put_symbol(unsigned int symbol)
+    {
+        if (symbol < 144)
+            put_code(0x30 + symbol, 8);
+        else if (symbol < 256)
+            put_code(0x190 + symbol - 144, 9);
+        else if (symbol < 280)
+            put_code(symbol - 256, 7);
+        else
+            put_code(0xC0 + symbol - 280, 8);
+    }
+
+    void put_match(size_t length, size_t distance)
+    {
+        static constexpr std::array<uint16_t, 29> length_base = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                                                   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static constexpr std::array<uint8_t, 29> length_extra = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                                                  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static constexpr std::array<uint16_t, 30> distance_base = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                                                    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                                                    8193, 12289, 16385, 24577 };
+        static constexpr std::array<uint8_t, 30> distance_extra = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                                                    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+        size_t code = length_base.size() - 1;
+        while (length_base[code] > length)
+            --code;
+        put_symbol(257 + code);
+        put_bits(length - length_base[code], length_extra[code]);
+
+        code = distance_base.size() - 1;
+        while (distance_base[code] > distance)
+            --code;
+        put_code(code, 5);
+        put_bits(distance - distance_base[code], distance_extra[code]);
+    }
+
+    void deflate_scanline()
+    {
+        const size_t length = scanline.size();
+        const bool row_above = has_previous && length <= MAX_DISTANCE;
+        for (size_t pos = 0; pos < length;)
+        {
+            const size_t max_length = std::min(MAX_MATCH, length - pos);
+            size_t run = 0, vertical = 0;
+            if (pos > 0)
+                while (run < max_length && scanline[pos + run] == scanline[pos + run - 1])
+                    ++run;
+            if (row_above)
+                while (vertical < max_length && scanline[pos + vertical] == previous_scanline[pos + vertical])
+                    ++vertical;
+
+            if (std::max(run, vertical) >= MIN_MATCH)
+            {
+                const size_t match = std::max(run, vertical);
+                put_match(match, (vertical >= run) ? length : 1);
+                pos += match;
+            }
+            else
+                put_symbol(scanline[pos++]);
+        }
+
+        for (const uint8_t byte : scanline)
+        {
+            adler_a = (adler_a + byte) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+    }
+
+public:
+    PngWriter(const std::string& filename, size_t width, size_t height, const std::vector<uint32_t>& palette)
+    : out(filename, std::ios::binary)
+    , width(width)
+    , previous_scanline(width + 1)
+    , scanline(width + 1)
+    {
+        if (!out)
+            throw std::runtime_error("Could not create " + filename);
+        if (palette.empty() || palette.size() > 256)
+            throw std::runtime_error("A PNG palette holds 1 to 256 colors");
+
+        static constexpr uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        out.write((const char*)signature, sizeof(signature));
+
+        std::vector<uint8_t> header;
+        append_u32(header, (uint32_t)width);
+        append_u32(header, (uint32_t)height);
+        // 8 bits per pixel, palette colors, deflate, adaptive filtering (only "none" is used), no interlacing
+        header.insert(header.end(), { 8, 3, 0, 0, 0 });
+        write_chunk("IHDR", header);
+
+        std::vector<uint8_t> colors;
+        for (const uint32_t color : palette)
+            colors.insert(colors.end(), { (uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color });
+        write_chunk("PLTE", colors);
+
+        // zlib header (deflate, 32K window), then a single block with the fixed codes
+        idat.insert(idat.end(), { 0x78, 0x01 });
+        put_bits(1, 1);
+        put_bits(1, 2);
+    }
+
+    void write_row(const uint8_t* pixels) override
+    {
+        std::swap(previous_scanline, scanline);
+        scanline[0] = 0;
+        std::copy(pixels, pixels + width, scanline.begin() + 1);
+        deflate_scanline();
+        has_previous = true;
+    }
+
+    void finish() override
+    {
+        // End of block, then the Adler-32 of the data, most significant byte first
+        put_symbol(256);
+        if (nr_bits > 0)
+            put_bits(0, 8 - nr_bits);
+        append_u32(idat, (adler_b << 16) | adler_a);
+        write_chunk("IDAT", idat);
+        idat.clear();
+
+        write_chunk("IEND", {});
+        out.flush();
+    }
+};
@@ -0,0 +1,175 @@
+#pragma once
+/*
+ * Validation and exact scoring of a solution against its building plan, shared by the validator and the regression
+ * runner. A solution is valid if
+ * - it fits in the budget,
+ * - every router is on a '.' cell, and on the backbone (the initial cell included),
+ * - the initial cell is not listed, no cell is listed twice,
+ * - and every backbone cell is connected to the initial cell (8-neighbourhood).
+ * Coverage is recomputed from scratch with a summed-area table of the walls, independently of the solvers' kernels.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../common/BitGrid.h"
+#include "../common/BuildingPlan.h"
+#include "../common/SolutionFile.h"
+#include "../common/SummedAreaTable.h"
+#include "../common/ThreadPool.h"
+
+struct Plan
+{
+    BuildingPlan building_plan;
+    SummedAreaTable walls;
+    BitGrid targets;
+
+    explicit Plan(const std::string& filename)
+    : building_plan(filename)
+    , walls(building_plan.rows(), building_plan.columns(), [&](int i, int j) { return building_plan[i][j] == '#'; })
+    , targets(building_plan.rows(), building_plan.columns(), [&](int i, int j) { return building_plan[i][j] == '.'; })
+    {
+    }
+};
+
+struct Report
+{
+    bool found = false;
+    std::string error;
+    long long score = 0, cells_covered = 0;
+};
+
+// Number of distinct target cells covered by the routers, counted as their bits get set in 'covered'
+inline long long count_cells_covered(const Plan& plan, const std::vector<std::pair<int, int>>& routers)
+{
+    const int nr_rows = plan.building_plan.rows(), nr_columns = plan.building_plan.columns();
+    const int radius = plan.building_plan.header().router_radius;
+    BitGrid covered(nr_rows, nr_columns);
+    std::atomic<long long> cells_covered = 0;
+
+    ThreadPool::global().parallel_for_chunks(0, routers.size(), 64, [&](size_t begin, size_t end)
+    {
+        long long newly_covered = 0;
+        for (size_t index = begin; index < end; ++index)
+        {
+            const auto [x, y] = routers[index];
+            for (int i = std::max(0, x - radius); i <= std::min(nr_rows - 1, x + radius); ++i)
+            {
+                const unsigned int* top = plan.walls.prefix_row(std::min(i, x));
+                const unsigned int* bottom = plan.walls.prefix_row(std::max(i, x) + 1);
+                uint64_t* covered_row = covered.row(i);
+
+                for (int j = std::max(0, y - radius); j <= std::min(nr_columns - 1, y + radius); ++j)
+                {
+                    const int left = std::min(j, y), right = std::max(j, y) + 1;
+                    if (!plan.targets.test(i, j) || bottom[right] - top[right] - bottom[left] + top[left] != 0)
+                        continue;
+
+                    // Routers of other chunks may cover the same cell: whoever sets its bit counts it
+                    const uint64_t bit = 1ull << (j % 64);
+                    std::atomic_ref<uint64_t> word(covered_row[j / 64]);
+                    if ((word.load(std::memory_order_relaxed) & bit) == 0 && (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0)
+                        ++newly_covered;
+                }
+            }
+        }
+        cells_covered += newly_covered;
+    });
+    return cells_covered;
+}
+
+// Why the solution is invalid, or nothing
+inline std::optional<std::string> check_solution(const Plan& plan, const SolutionFile& solution)
+{
+    const PlanHeader& header = plan.building_plan.header();
+    const int nr_rows = header.nr_rows, nr_columns = header.nr_columns;
+    const auto cell_name = [](std::pair<int, int> cell) { return "(" + std::to_string(cell.first) + ", " + std::to_string(cell.second) + ")"; };
+
+    const long long budget_used = (long long)solution.backbone.size() * header.backbone_cost + (long long)solution.routers.size() * header.router_cost;
+    if (budget_used > header.budget)
+        return "budget exceeded: " + std::to_string(budget_used) + " used out of " + std::to_string(header.budget);
+
+    BitGrid backbone(nr_rows, nr_columns);
+    backbone.set(header.initial_row, header.initial_column);
+    for (const auto& cell : solution.backbone)
+    {
+        if (cell == std::make_pair(header.initial_row, header.initial_column))
+            return "the initial backbone cell " + cell_name(cell) + " is listed";
+        if (backbone.test(cell.first, cell.second))
+            return "backbone cell " + cell_name(cell) + " is listed twice";
+        backbone.set(cell.first, cell.second);
+    }
+
+    BitGrid routers(nr_rows, nr_columns);
+    for (const auto& cell : solution.routers)
+    {
+        const char type = plan.building_plan[cell.first][cell.second];
+        if (type == '#' || type == '-')
+            return "router " + cell_name(cell) + " is placed on a '" + type + "' cell";
+        if (!backbone.test(cell.first, cell.second))
+            return "router " + cell_name(cell) + " is not on the backbone";
+        if (routers.test(cell.first, cell.second))
+            return "router " + cell_name(cell) + " is listed twice";
+        routers.set(cell.first, cell.second);
+    }
+
+    // Breadth-first search from the initial cell, through the backbone
+    BitGrid reached(nr_rows, nr_columns);
+    std::vector<std::pair<int, int>> wavefront = { { header.initial_row, header.initial_column } };
+    reached.set(header.initial_row, header.initial_column);
+    size_t nr_reached = 1;
+    while (!wavefront.empty())
+    {
+        const auto [i, j] = wavefront.back();
+        wavefront.pop_back();
+        for (int x = std::max(0, i - 1); x <= std::min(nr_rows - 1, i + 1); ++x)
+            for (int y = std::max(0, j - 1); y <= std::min(nr_columns - 1, j + 1); ++y)
+                if (backbone.test(x, y) && !reached.test(x, y))
+                {
+                    reached.set(x, y);
+                    wavefront.emplace_back(x, y);
+                    ++nr_reached;
+                }
+    }
+    if (nr_reached != solution.backbone.size() + 1)
+    {
+        for (const auto& cell : solution.backbone)
+            if (!reached.test(cell.first, cell.second))
+                return std::to_string(solution.backbone.size() + 1 - nr_reached) + " backbone cell(s) not connected to the initial cell, e.g. " + cell_name(cell);
+    }
+    return std::nullopt;
+}
+
+inline Report validate(const Plan& plan, const std::string& output_file)
+{
+    Report report;
+    if (!std::filesystem::exists(output_file))
+        return report;
+    report.found = true;
+
+    try
+    {
+        const PlanHeader& header = plan.building_plan.header();
+        const SolutionFile solution(output_file, header.nr_rows, header.nr_columns);
+        if (const auto error = check_solution(plan, solution))
+        {
+            report.error = *error;
+            return report;
+        }
+
+        const long long budget_used = (long long)solution.backbone.size() * header.backbone_cost + (long long)solution.routers.size() * header.router_cost;
+        report.cells_covered = count_cells_covered(plan, solution.routers);
+        report.score = report.cells_covered * 1000 + header.budget - budget_used;
+    }
+    catch (const std::exception& e)
+    {
+        report.error = e.what();
+    }
+    return report;
+}
@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Synthetic building plans, for scaling experiments: a floor of rooms and corridors of any size (20000 x 20000 is
+ * fine), written one row at a time, and the same for the same options and seed.
+ * Along each axis, the floor is cut into bands: rooms of random sizes separated by 1-cell walls, and every few rooms a
+ * corridor between two walls; a cell belongs to one row band and one column band, so the plan never needs to be held:
+ * only the bands are (O(rows + columns)), and every cell is computed from them and a hash of the seed:
+ * - the outer border is a wall,
+ * - a wall between two bands has a door in every band it crosses, and is open where it crosses a corridor,
+ * - corridors are '.', and so are rooms, but for the scattered walls (pillars, furniture) of --wall-density,
+ * - and some rooms, per --void-fraction, are out of the building ('-').
+ *
+ * Usage: generate [options] <output file.in>
+ *   --rows <n>, --columns <n>           size of the plan (default 1000 x 1000)
+ *   --seed <n>                          (default 1)
+ *   --room-size <min>,<max>             sides of the rooms (default 8,40)
+ *   --corridor-width <n>                (default 3)
+ *   --rooms-per-corridor <n>            rooms between two corridors along each axis (default 4)
+ *   --door-width <n>                    (default 2)
+ *   --wall-density <fraction>           walls scattered in the rooms (default 0.02)
+ *   --void-fraction <fraction>          rooms which are void (default 0.1)
+ *   --radius <n>                        router radius (default 7)
+ *   --backbone-cost <n>, --router-cost <n>   (default 1 and 100)
+ *   --budget <n>                        (default: a quarter of what covering the whole floor with routers would cost)
+ */
+
+struct Options
+{
+    int nr_rows = 1000, nr_columns = 1000;
+    uint64_t seed = 1;
+    int min_room_size = 8, max_room_size = 40;
+    int corridor_width = 3, rooms_per_corridor = 4, door_width = 2;
+    double wall_density = 0.02, void_fraction = 0.1;
+    int router_radius = 7, backbone_cost = 1, router_cost = 100;
+    long long budget = -1;
+};
+
+// splitmix64 finalizer: a well-mixed 64-bit hash of the seed and the given values
+uint64_t hash_values(uint64_t seed, uint64_t a, uint64_t b = 0, uint64_t c = 0)
+{
+    uint64_t x = seed;
+    for (const uint64_t value : { a, b, c })
+    {
+        x += 0x9E3779B97F4A7C15ull + value;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        x ^= x >> 31;
+    }
+    return x;
+}
+
+// In [0, 1)
+double hash_fraction(uint64_t hash)
+{
+    return (hash >> 11) * 0x1.0p-53;
+}
+
+// The cuts of one axis: every position belongs to a band, and the walls are bands of width 1
+class Axis
+{
+public:
+    enum Kind : uint8_t { WALL, ROOM, CORRIDOR };
+
+    struct Band
+    {
+        int start, length;
+        Kind kind;
+    };
+
+    vector<Band> bands;
+    // Band of every position
+    vector<uint32_t> band_of;
+
+    Axis(int length, const Options& options, uint64_t seed)
+    : band_of(length)
+    {
+        const auto add = [&](int band_length, Kind kind)
+        {
+            const int start = bands.empty() ? 0 : bands.back().start + bands.back().length;
+            band_length = min(band_length, length - 1 - start);
+            if (band_length <= 0)
+                return;
+            bands.push_back({ start, band_length, kind });
+            fill(band_of.begin() + start, band_of.begin() + start + band_length, (uint32_t)bands.size() - 1);
+        };
+
+        // The outer wall, then rooms and corridors, each followed by a wall, up to the other outer wall
+        add(1, WALL);
+        for (int nr_rooms = 0; !bands.empty() && bands.back().start + bands.back().length < length - 1; ++nr_rooms)
+        {
+            if (options.rooms_per_corridor > 0 && nr_rooms > 0 && nr_rooms % options.rooms_per_corridor == 0)
+                add(options.corridor_width, CORRIDOR);
+            else
+            {
+                const int span = options.max_room_size - options.min_room_size + 1;
+                add(options.min_room_size + (int)(hash_values(seed, bands.size()) % span), ROOM);
+            }
+            add(1, WALL);
+        }
+
+        // The last band reaches the outer wall, whatever its size
+        if (!bands.empty() && bands.back().kind != WALL)
+            add(1, WALL);
+        bands.push_back({ length - 1, 1, WALL });
+        band_of[length - 1] = bands.size() - 1;
+    }
+
+    [[nodiscard]] const Band& band(int position) const
+    {
+        return bands[band_of[position]];
+    }
+
+    [[nodiscard]] bool is_outer(int position) const
+    {
+        return band_of[position] == 0 || band_of[position] == bands.size() - 1;
+    }
+};
+
+class PlanGenerator
+{
+private:
+    const Options& options;
+    Axis rows, columns;
+
+    // Whether a wall band of one axis has a door where it crosses 'band' of the other axis (at 'offset' in it)
+    bool is_door(int wall_band, int band, int offset, uint64_t axis_tag) const
+    {
+        const Axis::Band& crossed = (axis_tag == 0) ? rows.bands[band] : columns.bands[band];
+        if (crossed.kind == Axis::CORRIDOR)
+            return true;
+        if (crossed.kind != Axis::ROOM)
+            return false;
+        const int door_width = min(options.door_width, crossed.length);
+        const int door_start = (int)(hash_values(options.seed, axis_tag, wall_band, band) % (crossed.length - door_width + 1));
+        return offset >= door_start && offset < door_start + door_width;
+    }
+
+public:
+    PlanGenerator(const Options& options)
+    : options(options)
+    , rows(options.nr_rows, options, hash_values(options.seed, 1))
+    , columns(options.nr_columns, options, hash_values(options.seed, 2))
+    {
+    }
+
+    char cell(int i, int j) const
+    {
+        if (rows.is_outer(i) || columns.is_outer(j))
+            return '#';
+
+        const uint32_t row_band = rows.band_of[i], column_band = columns.band_of[j];
+        const Axis::Band& row = rows.bands[row_band];
+        const Axis::Band& column = columns.bands[column_band];
+
+        if (row.kind == Axis::WALL && column.kind == Axis::WALL)
+            return '#';
+        // A vertical wall, crossing the row band of i
+        if (column.kind == Axis::WALL)
+            return is_door(column_band, row_band, i - row.start, 0) ? '.' : '#';
+        if (row.kind == Axis::WALL)
+            return is_door(row_band, column_band, j - column.start, 1) ? '.' : '#';
+
+        if (row.kind == Axis::CORRIDOR || column.kind == Axis::CORRIDOR)
+            return '.';
+        if (hash_fraction(hash_values(options.seed, 3, row_band, column_band)) < options.void_fraction)
+            return '-';
+        if (options.wall_density > 0 && hash_fraction(hash_values(options.seed, 4, i, j)) < options.wall_density)
+            return '#';
+        return '.';
+    }
+
+    // A '.' cell near the middle, in a corridor if there is one, for the initial backbone cell
+    pair<int, int> initial_cell() const
+    {
+        const int middle_row = options.nr_rows / 2;
+        for (int distance = 0; distance < options.nr_rows; ++distance)
+            for (const int i : { middle_row - distance, middle_row + distance })
+                if (i >= 0 && i < options.nr_rows && rows.band(i).kind == Axis::CORRIDOR)
+                    for (int j = options.nr_columns / 2; j < options.nr_columns; ++j)
+                        if (cell(i, j) == '.')
+                            return { i, j };
+
+        for (int i = middle_row; i < options.nr_rows; ++i)
+            for (int j = 0; j < options.nr_columns; ++j)
+                if (cell(i, j) == '.')
+                    return { i, j };
+        return { middle_row, options.nr_columns / 2 };
+    }
+
+    void write(const string& filename) const
+    {
+        ofstream out(filename, ios::binary);
+        if (!out)
+            throw runtime_error("Could not create " + filename);
+
+        long long budget = options.budget;
+        if (budget < 0)
+        {
+            const long long router_side = 2 * options.router_radius + 1;
+            const long long nr_routers = (long long)options.nr_rows * options.nr_columns / (router_side * router_side);
+            budget = min<long long>(INT_MAX, nr_routers * (options.router_cost + options.backbone_cost * router_side) / 4);
+        }
+
+        const auto [initial_row, initial_column] = initial_cell();
+        out << options.nr_rows << ' ' << options.nr_columns << ' ' << options.router_radius << '\n'
+            << options.backbone_cost << ' ' << options.router_cost << ' ' << budget << '\n'
+            << initial_row << ' ' << initial_column << '\n';
+
+        string row(options.nr_columns + 1, '\n');
+        for (int i = 0; i < options.nr_rows; ++i)
+        {
+            for (int j = 0; j < options.nr_columns; ++j)
+                row[j] = cell(i, j);
+            out.write(row.data(), row.size());
+        }
+        if (!out.flush())
+            throw runtime_error("Could not write " + filename);
+    }
+};
+
+int main(int argc, char** argv)
+{
+    Options options;
+    string output_file;
+    try
+    {
+        for (int index = 1; index < argc; ++index)
+        {
+            const string argument = argv[index];
+            const bool has_value = index + 1 < argc;
+            const auto next_int = [&] { return stoi(argv[++index]); };
+            const auto next_pair = [&](int& first, int& second)
+            {
+                const string value = argv[++index];
+                const size_t comma = value.find(',');
+                first = stoi(value.substr(0, comma));
+                second = (comma == string::npos) ? first : stoi(value.substr(comma + 1));
+            };
+
+            if (argument == "--rows" && has_value)
+                options.nr_rows = next_int();
+            else if (argument == "--columns" && has_value)
+                options.nr_columns = next_int();
+            else if (argument == "--seed" && has_value)
+                options.seed = stoull(argv[++index]);
+            else if (argument == "--room-size" && has_value)
+                next_pair(options.min_room_size, options.max_room_size);
+            else if (argument == "--corridor-width" && has_value)
+                options.corridor_width = next_int();
+            else if (argument == "--rooms-per-corridor" && has_value)
+                options.rooms_per_corridor = next_int();
+            else if (argument == "--door-width" && has_value)
+                options.door_width = next_int();
+            else if (argument == "--wall-density" && has_value)
+                options.wall_density = stod(argv[++index]);
+            else if (argument == "--void-fraction" && has_value)
+                options.void_fraction = stod(argv[++index]);
+            else if (argument == "--radius" && has_value)
+                options.router_radius = next_int();
+            else if (argument == "--backbone-cost" && has_value)
+                options.backbone_cost = next_int();
+            else if (argument == "--router-cost" && has_value)
+                options.router_cost = next_int();
+            else if (argument == "--budget" && has_value)
+                options.budget = stoll(argv[++index]);
+            else if (argument[0] != '-' && output_file.empty())
+                output_file = argument;
+            else
+                throw invalid_argument("unknown argument " + argument);
+        }
+
+        if (output_file.empty())
+            throw invalid_argument("no output file");
+        if (options.nr_rows < 1 || options.nr_columns < 1 || options.min_room_size < 1 || options.max_room_size < options.min_room_size ||
+            options.corridor_width < 1 || options.door_width < 1 || options.router_radius < 1 || options.budget > INT_MAX)
+            throw invalid_argument("invalid option value");
+
+        PlanGenerator(options).write(output_file);
+    }
+    catch (const exception& e)
+    {
+        cerr << "Error: " << e.what() << "\n"
+                "Usage: generate [--rows n] [--columns n] [--seed n] [--room-size min,max] [--corridor-width n]\n"
+                "                [--rooms-per-corridor n] [--door-width n] [--wall-density f] [--void-fraction f]\n"
+                "                [--radius n] [--backbone-cost n] [--router-cost n] [--budget n] <output file.in>\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,432 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../common/ThreadPool.h"
+#include "Scoring.h"
+
+using namespace std;
+
+/*
+ * End-to-end regression runner: every solver on every input (the competition ones, and any other plan given, e.g.
+ * a generated one), once per thread count, one run at a time. Each run records its wall time, its peak RSS and the
+ * exact score of its output (checked and scored as by the validator), and is appended to a CSV history; a run
+ * which scores less than the baseline of the same solver, input and thread count, or is slower than it by more than
+ * the tolerance, is flagged as a regression, and so is an invalid or failed run.
+ * The baseline is pinned, so that accepting a regression is a deliberate step: it is the checked-in reference
+ * (tools/regression_baseline.csv, in the history format), or the runs of the commit given with --baseline. The
+ * reference only moves with --update-baseline, which writes the valid runs of this run into it. Without a reference,
+ * the last valid runs of the history are the baseline, with a warning that it follows every accepted run.
+ *
+ * Usage: regress [options] <name>=<solver binary>...
+ *   --root <dir>            repository root, for input_files/ (default ../../, as from a build directory of tools)
+ *   --plan <file.in>        also run on this plan (repeatable)
+ *   --only-plans            run on the --plan files only
+ *   --threads <n,n,...>     thread counts, passed to the solvers as THREAD_POOL_SIZE (default: the hardware threads)
+ *   --history <file.csv>    history to append to (default <root>/regression_history.csv)
+ *   --baseline <commit>     compare with the valid runs of this commit in the history, instead of the reference
+ *   --reference <file.csv>  the checked-in reference (default <root>/tools/regression_baseline.csv)
+ *   --update-baseline       write the valid runs of this run into the reference, replacing the same solver, input
+ *                           and thread count
+ *   --tolerance <fraction>  slowdown tolerated before flagging, on top of 50 ms (default 0.10)
+ *   --work-dir <dir>        where the outputs and logs go (default: a temporary directory)
+ * Every solver is run as "<solver binary> <input file> <output file>". Only the solvers built on the thread pool
+ * (sol1, sol3) follow THREAD_POOL_SIZE; the others run the same way whatever the thread count.
+ * The exit code is 1 if anything regressed.
+ */
+
+const vector<string> INPUT_FILES = { "charleston_road", "lets_go_higher", "opera", "rue_de_londres" };
+const char* HISTORY_HEADER = "run,commit,solver,input,threads,wall_ms,peak_rss_kb,score,cells_covered,status";
+constexpr double TIME_SLACK_MS = 50;
+
+struct RunRecord
+{
+    string run, commit, solver, input;
+    size_t nr_threads = 0;
+    double wall_ms = 0;
+    long peak_rss_kb = 0;
+    long long score = 0, cells_covered = 0;
+    // "ok", or why the run is not valid
+    string status;
+};
+
+// CSV fields are quoted when they hold a comma or a quote
+string csv_field(const string& value)
+{
+    if (value.find_first_of(",\"\n") == string::npos)
+        return value;
+    string quoted = "\"";
+    for (const char c : value)
+        quoted += (c == '"') ? string("\"\"") : string(1, c);
+    return quoted + "\"";
+}
+
+vector<string> parse_csv_line(const string& line)
+{
+    vector<string> fields(1);
+    bool quoted = false;
+    for (size_t pos = 0; pos < line.size(); ++pos)
+    {
+        const char c = line[pos];
+        if (quoted && c == '"' && pos + 1 < line.size() && line[pos + 1] == '"')
+            fields.back() += line[++pos];
+        else if (c == '"')
+            quoted = !quoted;
+        else if (c == ',' && !quoted)
+            fields.emplace_back();
+        else
+            fields.back() += c;
+    }
+    return fields;
+}
+
+string to_csv(const RunRecord& record)
+{
+    ostringstream line;
+    line << csv_field(record.run) << ',' << csv_field(record.commit) << ',' << csv_field(record.solver) << ','
+         << csv_field(record.input) << ',' << record.nr_threads << ',' << fixed << record.wall_ms << ','
+         << record.peak_rss_kb << ',' << record.score << ',' << record.cells_covered << ',' << csv_field(record.status);
+    return line.str();
+}
+
+using RunKey = tuple<string, string, size_t>;
+
+vector<RunRecord> read_history(const string& filename)
+{
+    vector<RunRecord> history;
+    ifstream in(filename);
+    string line;
+    while (getline(in, line))
+    {
+        const vector<string> fields = parse_csv_line(line);
+        if (fields.size() != 10 || fields[0] == "run")
+            continue;
+        try
+        {
+            history.push_back({ fields[0], fields[1], fields[2], fields[3], stoul(fields[4]), stod(fields[5]), stol(fields[6]),
+                                stoll(fields[7]), stoll(fields[8]), fields[9] });
+        }
+        catch (const exception&)
+        {
+            cerr << "Warning: skipping a malformed line of " << filename << '\n';
+        }
+    }
+    return history;
+}
+
+// First line of what 'command' prints, or "unknown"
+string command_output(const string& command)
+{
+    unique_ptr<FILE, int (*)(FILE*)> pipe(popen(command.c_str(), "r"), pclose);
+    char buffer[128];
+    if (!pipe || !fgets(buffer, sizeof(buffer), pipe.get()))
+        return "unknown";
+    string output = buffer;
+    while (!output.empty() && (output.back() == '\n' || output.back() == '\r'))
+        output.pop_back();
+    return output.empty() ? "unknown" : output;
+}
+
+string utc_timestamp()
+{
+    const time_t now = time(nullptr);
+    tm utc{};
+    gmtime_r(&now, &utc);
+    char buffer[32];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return buffer;
+}
+
+struct ProcessResult
+{
+    // -1 if it did not exit normally
+    int exit_code = -1;
+    double wall_ms = 0;
+    long peak_rss_kb = 0;
+};
+
+// Runs 'arguments' with THREAD_POOL_SIZE set, its output going to 'log_file', and waits for it
+ProcessResult run_process(const vector<string>& arguments, size_t nr_threads, const string& log_file)
+{
+    vector<char*> argv;
+    for (const string& argument : arguments)
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    argv.push_back(nullptr);
+
+    ProcessResult result;
+    const auto start = chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid < 0)
+        throw runtime_error("fork failed");
+    if (pid == 0)
+    {
+        setenv("THREAD_POOL_SIZE", to_string(nr_threads).c_str(), 1);
+        const int log = open(log_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0)
+        {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    result.wall_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    // In kilobytes on Linux
+    result.peak_rss_kb = usage.ru_maxrss;
+    if (WIFEXITED(status))
+        result.exit_code = WEXITSTATUS(status);
+    return result;
+}
+
+// The last valid run of every (solver, input, thread count) of 'records', of 'commit' only if it is not empty
+map<RunKey, RunRecord> find_baselines(const vector<RunRecord>& records, const string& commit)
+{
+    map<RunKey, RunRecord> baselines;
+    for (const RunRecord& record : records)
+        if (record.status == "ok" && (commit.empty() || record.commit == commit))
+            baselines[{ record.solver, record.input, record.nr_threads }] = record;
+    return baselines;
+}
+
+vector<size_t> parse_thread_counts(const string& list)
+{
+    vector<size_t> counts;
+    stringstream in(list);
+    string count;
+    while (getline(in, count, ','))
+        if (const size_t nr_threads = stoul(count); nr_threads > 0)
+            counts.push_back(nr_threads);
+    return counts;
+}
+
+int main(int argc, char** argv)
+{
+    string root = "../../", history_file, work_dir, baseline_commit, reference_file;
+    vector<string> plans;
+    bool only_plans = false, update_baseline = false;
+    vector<size_t> thread_counts = { ThreadPool::default_nr_threads() };
+    double tolerance = 0.10;
+    vector<pair<string, string>> solvers;
+
+    for (int index = 1; index < argc; ++index)
+    {
+        const string argument = argv[index];
+        const bool has_value = index + 1 < argc;
+        if (argument == "--root" && has_value)
+            root = string(argv[++index]) + "/";
+        else if (argument == "--plan" && has_value)
+            plans.emplace_back(argv[++index]);
+        else if (argument == "--only-plans")
+            only_plans = true;
+        else if (argument == "--threads" && has_value)
+            thread_counts = parse_thread_counts(argv[++index]);
+        else if (argument == "--history" && has_value)
+            history_file = argv[++index];
+        else if (argument == "--baseline" && has_value)
+            baseline_commit = argv[++index];
+        else if (argument == "--reference" && has_value)
+            reference_file = argv[++index];
+        else if (argument == "--update-baseline")
+            update_baseline = true;
+        else if (argument == "--tolerance" && has_value)
+            tolerance = stod(argv[++index]);
+        else if (argument == "--work-dir" && has_value)
+            work_dir = argv[++index];
+        else if (const size_t separator = argument.find('='); separator != string::npos && argument[0] != '-')
+            solvers.emplace_back(argument.substr(0, separator), filesystem::absolute(argument.substr(separator + 1)).string());
+        else
+        {
+            cerr << "Unknown argument: " << argument << '\n';
+            return 1;
+        }
+    }
+    if (solvers.empty() || thread_counts.empty())
+    {
+        cerr << "Usage: regress [--root dir] [--plan file.in]... [--only-plans] [--threads n,n,...] [--history file.csv]\n"
+                "               [--baseline commit] [--reference file.csv] [--update-baseline] [--tolerance fraction]\n"
+                "               [--work-dir dir] <name>=<solver binary>...\n";
+        return 1;
+    }
+    if (history_file.empty())
+        history_file = root + "regression_history.csv";
+    if (reference_file.empty())
+        reference_file = root + "tools/regression_baseline.csv";
+    if (work_dir.empty())
+        work_dir = (filesystem::temp_directory_path() / ("regress-" + to_string(getpid()))).string();
+
+    // The inputs, by name
+    vector<pair<string, string>> inputs;
+    if (!only_plans)
+        for (const string& input : INPUT_FILES)
+            inputs.emplace_back(input, root + "input_files/" + input + ".in");
+    for (const string& plan : plans)
+        inputs.emplace_back(filesystem::path(plan).stem().string(), plan);
+
+    // The history holds the short hashes that rev-parse gives
+    string baseline;
+    if (!baseline_commit.empty())
+    {
+        baseline = command_output("git -C \"" + root + "\" rev-parse --short \"" + baseline_commit + "\" 2>/dev/null");
+        if (baseline == "unknown")
+            baseline = baseline_commit;
+    }
+    const vector<RunRecord> reference = read_history(reference_file);
+    const bool has_reference = filesystem::exists(reference_file);
+    map<RunKey, RunRecord> baselines;
+    string baseline_name;
+    if (!baseline.empty())
+    {
+        baselines = find_baselines(read_history(history_file), baseline);
+        baseline_name = "commit " + baseline;
+        if (baselines.empty())
+            cerr << "Warning: no valid run of commit " << baseline << " in " << history_file << '\n';
+    }
+    else if (has_reference)
+    {
+        baselines = find_baselines(reference, "");
+        baseline_name = reference_file;
+    }
+    else
+    {
+        baselines = find_baselines(read_history(history_file), "");
+        baseline_name = "last valid runs of the history";
+        cerr << "Warning: no reference at " << reference_file << ", comparing with the last valid runs of the history, "
+                "which follow every accepted run; pin one with --update-baseline\n";
+    }
+
+    const bool new_history = !filesystem::exists(history_file);
+    ofstream history(history_file, ios::app);
+    if (!history)
+    {
+        cerr << "Error: could not open " << history_file << '\n';
+        return 1;
+    }
+    if (new_history)
+        history << HISTORY_HEADER << '\n';
+
+    const string run = utc_timestamp();
+    const string commit = command_output("git -C \"" + root + "\" rev-parse --short HEAD 2>/dev/null");
+    printf("run %s, commit %s, history %s, baseline %s\n", run.c_str(), commit.c_str(), history_file.c_str(), baseline_name.c_str());
+    printf("%-10s %-24s %7s %10s %10s %14s %10s  %s\n", "solver", "input", "threads", "wall (s)", "RSS (MB)", "score", "vs base", "status");
+
+    bool regressed = false;
+    vector<RunRecord> records;
+    for (const auto& [input, input_file] : inputs)
+    {
+        unique_ptr<Plan> plan;
+        string plan_error;
+        try
+        {
+            plan = make_unique<Plan>(input_file);
+        }
+        catch (const exception& e)
+        {
+            plan_error = e.what();
+        }
+
+        for (const auto& [solver, binary] : solvers)
+        {
+            const string output_dir = work_dir + "/" + solver;
+            filesystem::create_directories(output_dir);
+
+            for (const size_t nr_threads : thread_counts)
+            {
+                RunRecord record{ run, commit, solver, input, nr_threads, 0, 0, 0, 0, "" };
+                const string output_file = output_dir + "/" + input;
+                filesystem::remove(output_file);
+
+                if (!plan)
+                    record.status = "bad input: " + plan_error;
+                else
+                {
+                    const ProcessResult process = run_process({ binary, filesystem::absolute(input_file).string(), output_file },
+                                                              nr_threads, output_file + "." + to_string(nr_threads) + ".log");
+                    record.wall_ms = process.wall_ms;
+                    record.peak_rss_kb = process.peak_rss_kb;
+
+                    if (process.exit_code != 0)
+                        record.status = "failed: exit code " + to_string(process.exit_code);
+                    else
+                    {
+                        const Report report = validate(*plan, output_file);
+                        record.score = report.score;
+                        record.cells_covered = report.cells_covered;
+                        record.status = !report.found ? "failed: no output" : report.error.empty() ? "ok" : "invalid: " + report.error;
+                    }
+                }
+
+                // Compared with the baseline
+                string comparison = "new";
+                vector<string> regressions;
+                if (record.status != "ok")
+                    regressions.push_back(record.status);
+                else if (const auto baseline = baselines.find({ solver, input, nr_threads }); baseline != baselines.end())
+                {
+                    const RunRecord& base = baseline->second;
+                    char change[32];
+                    snprintf(change, sizeof(change), "%+.1f%%", 100 * (record.wall_ms / max(base.wall_ms, 1e-3) - 1));
+                    comparison = change;
+                    if (record.score < base.score)
+                        regressions.push_back("score down by " + to_string(base.score - record.score));
+                    if (record.wall_ms > base.wall_ms * (1 + tolerance) + TIME_SLACK_MS)
+                        regressions.push_back("slower than " + to_string((long long)base.wall_ms) + " ms");
+                }
+
+                string status = regressions.empty() ? "ok" : "REGRESSION";
+                for (const string& regression : regressions)
+                    status += ": " + regression;
+                regressed |= !regressions.empty();
+
+                printf("%-10s %-24s %7zu %10.2f %10.1f %14lld %10s  %s\n", solver.c_str(), input.c_str(), nr_threads,
+                       record.wall_ms / 1000, record.peak_rss_kb / 1024.0, record.score, comparison.c_str(), status.c_str());
+                fflush(stdout);
+                history << to_csv(record) << '\n' << flush;
+                records.push_back(record);
+            }
+        }
+    }
+
+    if (update_baseline)
+    {
+        // The reference keeps its runs of the other solvers, inputs and thread counts
+        map<RunKey, RunRecord> updated = find_baselines(reference, "");
+        for (const RunRecord& record : records)
+            if (record.status == "ok")
+                updated[{ record.solver, record.input, record.nr_threads }] = record;
+
+        ofstream out(reference_file, ios::trunc);
+        out << HISTORY_HEADER << '\n';
+        for (const auto& [key, record] : updated)
+            out << to_csv(record) << '\n';
+        if (!out.flush())
+        {
+            cerr << "Error: could not write " << reference_file << '\n';
+            return 1;
+        }
+        printf("baseline written to %s\n", reference_file.c_str());
+    }
+
+    printf("outputs and logs in %s\n", work_dir.c_str());
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../common/BuildingPlan.h"
+#include "../common/SolutionFile.h"
+#include "../common/ThreadPool.h"
+#include "ImageWriter.h"
+
+using namespace std;
+
+/*
+ * Draws the solutions over their building plans, like visualizer.py did (same colors: walls, target cells, void cells,
+ * backbone in yellow, routers in red), but one image row at a time: the plan is read from the mapped file, and the
+ * backbone and the routers are streamed from the mapped solution file in row order, so only the current row of
+ * cells is ever built. The solvers write both sections in row order, and then the memory needed is O(columns)
+ * whatever the size of the plan (plus the routers of the 2R + 1 rows around the current one with --coverage); a
+ * section which is not in row order is loaded and sorted instead, for O(cells of the section). With --coverage,
+ * target cells covered by the routers are shaded by how many routers cover them, which shows the overlap.
+ *
+ * Usage: render [--coverage] [--scale k] [repository root] [solution...]
+ *          renders visualizers/<solution>/<input>.png for every solution and input, all at once
+ *        render [--coverage] [--scale k] --plan <input.in> <output file> <image.png|image.ppm>
+ * By default, each cell is drawn as a square of pixels sized so the longer side of the image is about 9000 pixels.
+ */
+
+const vector<string> INPUT_FILES = { "charleston_road", "lets_go_higher", "opera", "rue_de_londres" };
+const vector<string> SOLUTIONS = { "sol1", "sol2", "sol2i", "sol3" };
+
+enum Color : uint8_t { WALL, TARGET, VOID, BACKBONE, ROUTER, COVERED_ONCE, COVERED_TWICE, COVERED_3_TIMES, COVERED_4_TIMES_OR_MORE };
+const vector<uint32_t> PALETTE = { 0x092327, 0x00a9a5, 0x0b5351, 0xffd166, 0xff0000, 0x52c7c4, 0x8fdcd9, 0xc7efed, 0xffffff };
+
+struct RenderOptions
+{
+    bool coverage = false;
+    int scale = 0;
+};
+
+using Cell = pair<int, int>;
+
+// The cells of a solution section in row order: streamed straight from the file if it is in row order already,
+// or else loaded and sorted
+class RowOrderedCells
+{
+private:
+    SolutionStream::Section section;
+    bool streamed;
+    vector<Cell> sorted;
+    size_t next_sorted = 0;
+    optional<Cell> next_cell;
+
+    void advance()
+    {
+        Cell cell;
+        if (streamed ? section.next(cell) : next_sorted < sorted.size())
+            next_cell = streamed ? cell : sorted[next_sorted++];
+        else
+            next_cell.reset();
+    }
+
+public:
+    explicit RowOrderedCells(SolutionStream::Section cells)
+    : section(cells)
+    , streamed(cells.is_row_ordered())
+    {
+        if (!streamed)
+        {
+            Cell cell;
+            while (section.next(cell))
+                sorted.push_back(cell);
+            sort(sorted.begin(), sorted.end());
+        }
+        advance();
+    }
+
+    // Takes the next cell if it lies in a row up to 'last_row'
+    bool next_up_to(int last_row, Cell& cell)
+    {
+        if (!next_cell.has_value() || next_cell->first > last_row)
+            return false;
+        cell = next_cell.value();
+        advance();
+        return true;
+    }
+};
+
+// Adds, for every target cell of row 'i', the number of routers covering it: only the routers within R rows can,
+// and a router covers a cell iff their bounding rectangle has no wall, which is checked column by column outwards
+void add_coverage(const BuildingPlan& plan, int i, const deque<Cell>& near_routers, vector<uint8_t>& counts)
+{
+    const int nr_columns = plan.columns(), radius = plan.header().router_radius;
+    for (const auto& [x, y] : near_routers)
+    {
+        const int top = min(x, i), bottom = max(x, i);
+        const auto column_is_clear = [&](int j)
+        {
+            for (int row = top; row <= bottom; ++row)
+                if (plan[row][j] == '#')
+                    return false;
+            return true;
+        };
+
+        // Every rectangle includes the router's own column
+        if (!column_is_clear(y))
+            continue;
+        for (int direction : { 1, -1 })
+            for (int j = (direction == 1) ? y : y - 1; j >= 0 && j < nr_columns && abs(j - y) <= radius && column_is_clear(j); j += direction)
+                if (plan[i][j] == '.' && counts[j] < 4)
+                    ++counts[j];
+    }
+}
+
+void render(const BuildingPlan& plan, const string& output_file, const string& image_file, const RenderOptions& options)
+{
+    const int nr_rows = plan.rows(), nr_columns = plan.columns(), radius = plan.header().router_radius;
+    const int scale = (options.scale > 0) ? options.scale : max(1, 9000 / max(nr_rows, nr_columns));
+
+    const SolutionStream solution(output_file, nr_rows, nr_columns);
+    RowOrderedCells backbone(solution.backbone()), routers(solution.routers());
+
+    const size_t width = (size_t)nr_columns * scale, height = (size_t)nr_rows * scale;
+    unique_ptr<ImageWriter> image;
+    if (image_file.ends_with(".ppm"))
+        image = make_unique<PpmWriter>(image_file, width, height, PALETTE);
+    else
+        image = make_unique<PngWriter>(image_file, width, height, PALETTE);
+
+    vector<uint8_t> cells(nr_columns), counts(nr_columns), pixels(width);
+    // The routers of the rows [i - R, i + R] with --coverage (they can cover cells of row i), of row i otherwise
+    deque<Cell> near_routers;
+    const int reach = options.coverage ? radius : 0;
+    for (int i = 0; i < nr_rows; ++i)
+    {
+        const char* row = plan[i];
+        for (int j = 0; j < nr_columns; ++j)
+            cells[j] = (row[j] == '#') ? WALL : (row[j] == '.') ? TARGET : VOID;
+
+        while (!near_routers.empty() && near_routers.front().first < i - reach)
+            near_routers.pop_front();
+        for (Cell router; routers.next_up_to(i + reach, router);)
+            near_routers.push_back(router);
+
+        if (options.coverage)
+        {
+            fill(counts.begin(), counts.end(), 0);
+            add_coverage(plan, i, near_routers, counts);
+            for (int j = 0; j < nr_columns; ++j)
+                if (counts[j] > 0)
+                    cells[j] = COVERED_ONCE + counts[j] - 1;
+        }
+
+        for (Cell cell; backbone.next_up_to(i, cell);)
+            cells[cell.second] = BACKBONE;
+        for (const auto& [x, y] : near_routers)
+            if (x == i)
+                cells[y] = ROUTER;
+
+        for (int j = 0; j < nr_columns; ++j)
+            fill_n(pixels.begin() + (size_t)j * scale, scale, cells[j]);
+        for (int repeat = 0; repeat < scale; ++repeat)
+            image->write_row(pixels.data());
+    }
+    image->finish();
+}
+
+int main(int argc, char** argv)
+{
+    RenderOptions options;
+    vector<string> arguments;
+    for (int index = 1; index < argc; ++index)
+    {
+        const string argument = argv[index];
+        if (argument == "--coverage")
+            options.coverage = true;
+        else if (argument == "--scale" && index + 1 < argc)
+            options.scale = stoi(argv[++index]);
+        else
+            arguments.push_back(argument);
+    }
+
+    try
+    {
+        if (!arguments.empty() && arguments[0] == "--plan")
+        {
+            if (arguments.size() != 4)
+            {
+                cerr << "Usage: render [--coverage] [--scale k] --plan <input.in> <output file> <image.png|image.ppm>\n";
+                return 1;
+            }
+            render(BuildingPlan(arguments[1]), arguments[2], arguments[3], options);
+            return 0;
+        }
+    }
+    catch (const exception& e)
+    {
+        cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+
+    const string root = !arguments.empty() ? arguments[0] + "/" : string("../../");
+    const vector<string> solutions = (arguments.size() > 1) ? vector<string>(arguments.begin() + 1, arguments.end()) : SOLUTIONS;
+
+    // Every (solution, input) pair at once; the plans are mapped once per image, which costs nothing
+    vector<string> messages(solutions.size() * INPUT_FILES.size());
+    atomic<bool> all_rendered = true;
+    ThreadPool::global().parallel_for(0, messages.size(), 1, [&](size_t index)
+    {
+        const string& solution = solutions[index / INPUT_FILES.size()];
+        const string& input = INPUT_FILES[index % INPUT_FILES.size()];
+        const string output_file = "output_files/" + solution + "/" + input;
+        if (!filesystem::exists(root + output_file))
+        {
+            messages[index] = "Error: File '" + output_file + "' not found.";
+            return;
+        }
+
+        try
+        {
+            filesystem::create_directories(root + "visualizers/" + solution);
+            render(BuildingPlan(root + "input_files/" + input + ".in"), root + output_file, root + "visualizers/" + solution + "/" + input + ".png", options);
+        }
+        catch (const exception& e)
+        {
+            messages[index] = "Error: '" + output_file + "': " + e.what();
+            all_rendered = false;
+        }
+    });
+
+    for (const string& message : messages)
+        if (!message.empty())
+            cout << message << '\n';
+    return all_rendered ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../common/BuildingPlan.h"
+#include "../common/ThreadPool.h"
+#include "Scoring.h"
+
+using namespace std;
+
+/*
+ * Checks every solution output against its building plan and computes its exact score (see Scoring.h), like
+ * validate.py but in parallel: all the (solution, input) pairs at once, and the routers of each one in chunks.
+ *
+ * Usage: validate [repository root] [solution...]
+ * It is run from a build directory inside tools/ by default, like the solvers.
+ */
+
+const vector<string> INPUT_FILES = { "charleston_road", "lets_go_higher", "opera", "rue_de_londres" };
+const vector<string> SOLUTIONS = { "sol1", "sol2", "sol2i", "sol3" };
+
+// 1234567 -> "1,234,567"
+string with_separators(long long value)
+{
+    string digits = to_string(value < 0 ? -value : value);
+    for (int pos = (int)digits.size() - 3; pos > 0; pos -= 3)
+        digits.insert(pos, ",");
+    return (value < 0 ? "-" : "") + digits;
+}
+
+int main(int argc, char** argv)
+{
+    const string root = (argc > 1) ? string(argv[1]) + "/" : string("../../");
+    const vector<string> solutions = (argc > 2) ? vector<string>(argv + 2, argv + argc) : SOLUTIONS;
+
+    vector<unique_ptr<Plan>> plans(INPUT_FILES.size());
+    vector<string> plan_errors(INPUT_FILES.size());
+    ThreadPool::global().parallel_for(0, INPUT_FILES.size(), 1, [&](size_t input)
+    {
+        try
+        {
+            plans[input] = make_unique<Plan>(root + "input_files/" + INPUT_FILES[input] + ".in");
+        }
+        catch (const exception& e)
+        {
+            plan_errors[input] = e.what();
+        }
+    });
+    for (size_t input = 0; input < INPUT_FILES.size(); ++input)
+        if (!plans[input])
+        {
+            cerr << "Error: " << plan_errors[input] << '\n';
+            return 1;
+        }
+
+    // Every (solution, input) pair at once
+    vector<Report> reports(solutions.size() * INPUT_FILES.size());
+    ThreadPool::global().parallel_for(0, reports.size(), 1, [&](size_t index)
+    {
+        const size_t solution = index / INPUT_FILES.size(), input = index % INPUT_FILES.size();
+        reports[index] = validate(*plans[input], root + "output_files/" + solutions[solution] + "/" + INPUT_FILES[input]);
+    });
+
+    // Errors first, then the scores of the valid solutions, as validate.py prints them
+    bool all_valid = true;
+    for (size_t index = 0; index < reports.size(); ++index)
+    {
+        const string output_file = "output_files/" + solutions[index / INPUT_FILES.size()] + "/" + INPUT_FILES[index % INPUT_FILES.size()];
+        if (!reports[index].found)
+            cout << "Error: File '" << output_file << "' not found.\n";
+        else if (!reports[index].error.empty())
+        {
+            cout << "Error: '" << output_file << "' is invalid: " << reports[index].error << '\n';
+            all_valid = false;
+        }
+    }
+
+    for (size_t solution = 0; solution < solutions.size(); ++solution)
+    {
+        cout << "For " << solutions[solution] << ":\n";
+        long long final_score = 0, total_covered = 0;
+        for (size_t input = 0; input < INPUT_FILES.size(); ++input)
+        {
+            const Report& report = reports[solution * INPUT_FILES.size() + input];
+            if (!report.found || !report.error.empty())
+                continue;
+            cout << "--->" << INPUT_FILES[input] << ": " << with_separators(report.score) << " score, "
+                 << with_separators(report.cells_covered) << " cells covered.\n";
+            final_score += report.score;
+            total_covered += report.cells_covered;
+        }
+        cout << "Final score: " << with_separators(final_score) << ", cells covered: " << with_separators(total_covered) << "\n\n";
+    }
+    return all_valid ? 0 : 1;
+}